@@ -183,6 +183,12 @@ I3_CPPFLAGS += -D_GNU_SOURCE
 endif
 
 
+# NO_DEBUG_LOG=1 compiles out all DLOG() calls of i3. "debuglog on" and the SHM
+# log then only contain LOG() and ELOG() messages.
+ifeq ($(NO_DEBUG_LOG),1)
+I3_CPPFLAGS += -DI3_NO_DEBUG_LOG
+endif
+
 ifeq ($(COVERAGE),1)
 I3_CFLAGS += -fprofile-arcs -ftest-coverage
 LIBS += -lgcov
@@ -0,0 +1,114 @@
+#!/usr/bin/env perl
+# vim:ts=4:sw=4:expandtab
+#
+# i3 - an improved dynamic tiling window manager
+# © 2009 Michael Stapelberg and contributors (see also: LICENSE)
+#
+# bench-criteria.pl: measures how long i3 takes to run commands with criteria
+# which have to be checked against every window, with debug logging (and the
+# SHM log) switched off and on.
+#
+# Run it inside a (preferably nested, e.g. Xephyr) X session managed by the
+# i3 you want to measure:
+#
+#     DISPLAY=:1 ./contrib/bench-criteria.pl --windows 500 --commands 2000
+#
+# To measure what compiling DLOG() out saves, run it once against an i3 built
+# normally and once against one built with "make NO_DEBUG_LOG=1" and compare
+# the "debuglog off" lines. contrib/bench-dlog.c measures the same without X11
+# and without a running i3.
+#
+# Requires AnyEvent::I3 and X11::XCB (like the testsuite).
+
+use strict;
+use warnings;
+use AnyEvent::I3;
+use Getopt::Long;
+use Time::HiRes qw(time);
+use X11::XCB qw(:all);
+use X11::XCB::Connection;
+use v5.10;
+
+my $windows = 500;
+my $commands = 2000;
+my $workspace = 'bench-criteria';
+
+GetOptions(
+    'windows=i' => \$windows,
+    'commands=i' => \$commands,
+    'workspace=s' => \$workspace,
+) or die "Usage: $0 [--windows N] [--commands N] [--workspace NAME]\n";
+
+my $i3 = i3();
+$i3->connect->recv or die "Could not connect to i3: $!";
+
+sub cmd {
+    my ($command) = @_;
+    my $reply = $i3->command($command)->recv;
+    die "Command \"$command\" failed" unless $reply->[0]->{success};
+}
+
+# Open the windows on a workspace of their own. They are mapped without
+# waiting for each of them, the tree is polled afterwards instead.
+cmd(qq|workspace "$workspace"|);
+cmd('layout tabbed');
+
+my $x = X11::XCB::Connection->new;
+my @windows;
+for my $c (1 .. $windows) {
+    my $window = $x->root->create_child(
+        class => WINDOW_CLASS_INPUT_OUTPUT,
+        rect => [ 0, 0, 30, 30 ],
+        background_color => '#c0c0c0',
+        name => "bench window $c",
+        wm_class => "bench-$c",
+    );
+    $window->map;
+    push @windows, $window;
+}
+$x->flush;
+
+# Wait until i3 managed all windows.
+for (1 .. 100) {
+    my $tree = $i3->get_tree->recv;
+    my $count = 0;
+    my @nodes = ($tree);
+    while (my $node = shift @nodes) {
+        $count++ if defined($node->{window}) &&
+                    ($node->{name} // '') =~ /^bench window /;
+        push @nodes, @{$node->{nodes}}, @{$node->{floating_nodes}};
+    }
+    last if $count == $windows;
+    select(undef, undef, undef, 0.1);
+}
+
+# None of the windows matches, so every command checks the class of every
+# window and then does nothing.
+my $command = '[class="^no-such-window$" title="^no$"] nop';
+
+sub measure {
+    my ($label) = @_;
+    # Warm up.
+    cmd($command) for 1 .. 50;
+    my $start = time();
+    cmd($command) for 1 .. $commands;
+    my $elapsed = time() - $start;
+    printf("%-16s %8.1f µs per command, %6.1f ns per window check\n",
+           $label,
+           ($elapsed / $commands) * 1e6,
+           ($elapsed / ($commands * $windows)) * 1e9);
+}
+
+say "$windows windows, $commands commands of the form: $command";
+cmd('shmlog off');
+cmd('debuglog off');
+measure('debuglog off');
+cmd('debuglog on');
+measure('debuglog on');
+cmd('debuglog off');
+cmd('shmlog on');
+measure('shmlog on');
+cmd('shmlog off');
+
+$_->unmap for @windows;
+$x->flush;
@@ -0,0 +1,136 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * bench-dlog.c: microbenchmark for the cost of DLOG() while debug logging and
+ *               the SHM log are switched off. It runs a check modelled after
+ *               match_matches_window() (6 log calls per window) with three
+ *               variants of DLOG():
+ *
+ *               - old: always calls into log.c, which returns early,
+ *               - new: branches on debuglog_enabled before calling (as
+ *                 include/log.h does now),
+ *               - compiled out: what "make NO_DEBUG_LOG=1" does.
+ *
+ * Build and run it with:
+ *
+ *     gcc -std=c99 -O2 -o bench-dlog contrib/bench-dlog.c && ./bench-dlog
+ *
+ * The log functions are kept out of line, like they are in log.c, so that the
+ * compiler cannot see that they do nothing.
+ *
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+bool logbuffer_on = false;
+bool debug_logging = false;
+bool debuglog_enabled = false;
+
+__attribute__((noinline)) void debuglog(char *fmt, ...) {
+    va_list args;
+
+    if (!logbuffer_on && !debug_logging)
+        return;
+
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+__attribute__((noinline)) void debuglog_at(const char *file, const char *function, int line, char *fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+    printf("%s:%s:%d - ", file, function, line);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+__attribute__((noinline)) const char *i3string_as_utf8(const char *str) {
+    return str;
+}
+
+#define OLD_DLOG(fmt, ...) debuglog("%s:%s:%d - " fmt, "match.c", __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define NEW_DLOG(fmt, ...)                                                      \
+    do {                                                                        \
+        if (debuglog_enabled)                                                   \
+            debuglog_at("match.c", __FUNCTION__, __LINE__, fmt, ##__VA_ARGS__); \
+    } while (0)
+#define NO_DLOG(fmt, ...)                                                       \
+    do {                                                                        \
+        if (0)                                                                  \
+            debuglog_at("match.c", __FUNCTION__, __LINE__, fmt, ##__VA_ARGS__); \
+    } while (0)
+
+typedef struct window {
+    int id;
+    const char *class_class;
+    const char *class_instance;
+    const char *name;
+    const char *role;
+} window;
+
+#define CHECK_WINDOW(variant, LOGFN)                                             \
+    static int check_window_##variant(window *window) {                          \
+        int matches = 0;                                                         \
+        LOGFN("Checking window 0x%08x (class %s)\n", window->id,                 \
+              window->class_class);                                              \
+        if (strcmp(window->class_class, "Firefox") == 0) {                       \
+            matches++;                                                           \
+            LOGFN("window class matches (%s)\n", window->class_class);           \
+        }                                                                        \
+        if (strcmp(window->class_instance, "Navigator") == 0) {                  \
+            matches++;                                                           \
+            LOGFN("window instance matches (%s)\n", window->class_instance);     \
+        }                                                                        \
+        if (window->name[0] != '\0') {                                           \
+            matches++;                                                           \
+            LOGFN("title matches (%s)\n", i3string_as_utf8(window->name));       \
+        }                                                                        \
+        if (window->role[0] != '\0') {                                           \
+            matches++;                                                           \
+            LOGFN("window_role matches (%s)\n", window->role);                   \
+        }                                                                        \
+        LOGFN("mark does not match\n");                                          \
+        return matches;                                                          \
+    }
+
+CHECK_WINDOW(old, OLD_DLOG)
+CHECK_WINDOW(new, NEW_DLOG)
+CHECK_WINDOW(compiled_out, NO_DLOG)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void) {
+    window window = {1, "Firefox", "Navigator", "title", "browser"};
+    struct {
+        const char *label;
+        int (*check)(struct window *);
+    } variants[] = {
+        {"old DLOG (call into debuglog)", check_window_old},
+        {"new DLOG (branch on global)", check_window_new},
+        {"compiled out", check_window_compiled_out},
+    };
+    const int iterations = 20000000;
+
+    for (size_t c = 0; c < sizeof(variants) / sizeof(variants[0]); c++) {
+        volatile int sum = 0;
+        const double start = now_ns();
+        for (int i = 0; i < iterations; i++)
+            sum += variants[c].check(&window);
+        printf("%-30s %6.2f ns/window\n", variants[c].label, (now_ns() - start) / iterations);
+    }
+
+    return 0;
+}
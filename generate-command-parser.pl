@@ -127,6 +127,17 @@ for my $state (@keys, '__CALL') {
     $cnt++;
 }
 say $enumfh '} cmdp_state;';
+# The kinds of tokens, so that the parser does not need to compare token names
+# to find out how to match a token.
+say $enumfh 'typedef enum {';
+say $enumfh '    TOKEN_LITERAL = 0,';
+say $enumfh '    TOKEN_STRING,';
+say $enumfh '    TOKEN_WORD,';
+say $enumfh '    TOKEN_NUMBER,';
+say $enumfh '    TOKEN_LINE,';
+say $enumfh '    TOKEN_END,';
+say $enumfh '    TOKEN_ERROR';
+say $enumfh '} cmdp_token_kind;';
 close($enumfh);
 
 # Third step: Generate the call function.
@@ -135,6 +146,7 @@ my $resultname = uc(substr($prefix, 0, 1)) . substr($prefix, 1) . 'ResultIR';
 say $callfh "static void GENERATED_call(const int call_identifier, struct $resultname *result) {";
 say $callfh '    switch (call_identifier) {';
 my $call_id = 0;
+my @call_next_states;
 for my $state (@keys) {
     my $tokens = $states{$state};
     for my $token (@$tokens) {
@@ -163,6 +175,7 @@ for my $state (@keys) {
 
         say $callfh "         case $call_id:";
         say $callfh "             result->next_state = $next_state;";
+        push @call_next_states, $next_state;
         say $callfh '#ifndef TEST_PARSER';
         my $real_cmd = $cmd;
         if ($real_cmd =~ /\(\)/) {
@@ -194,22 +207,46 @@ say $callfh '            printf("BUG in the parser. state = %d\n", call_identifi
 say $callfh '            assert(false);';
 say $callfh '    }';
 say $callfh '}';
+if ($prefix eq 'command') {
+    # The state GENERATED_call() transitions to for each call_identifier, for
+    # looking it up without making the call (see command_program_new()).
+    say $callfh '';
+    say $callfh 'static const cmdp_state GENERATED_call_next_state[] = {';
+    say $callfh "    $_," for @call_next_states;
+    say $callfh '};';
+}
 close($callfh);
 
 # Fourth step: Generate the token datastructures.
 
 open(my $tokfh, '>', "GENERATED_${prefix}_tokens.h");
 
+my %token_kinds = (
+    string => 'TOKEN_STRING',
+    word => 'TOKEN_WORD',
+    number => 'TOKEN_NUMBER',
+    line => 'TOKEN_LINE',
+    end => 'TOKEN_END',
+    error => 'TOKEN_ERROR',
+);
+
 for my $state (@keys) {
     my $tokens = $states{$state};
     say $tokfh 'static cmdp_token tokens_' . $state . '[' . scalar @$tokens . '] = {';
     for my $token (@$tokens) {
         my $call_identifier = 0;
         my $token_name = $token->{token};
+        my $kind;
+        my $length = 0;
         if ($token_name =~ /^'/) {
             # To make the C code simpler, we leave out the trailing single
             # quote of the literal. We can do strdup(literal + 1); then :).
             $token_name =~ s/'$//;
+            $kind = 'TOKEN_LITERAL';
+            $length = length($token_name) - 1;
+        } else {
+            $kind = $token_kinds{$token_name};
+            die qq|Unknown token "$token_name" in state $state| unless defined($kind);
         }
         my $next_state = $token->{next_state};
         if ($next_state =~ /^call /) {
@@ -217,7 +254,7 @@ for my $state (@keys) {
             $next_state = '__CALL';
         }
         my $identifier = $token->{identifier};
-        say $tokfh qq|    { "$token_name", "$identifier", $next_state, { $call_identifier } }, |;
+        say $tokfh qq|    { "$token_name", "$identifier", $next_state, { $call_identifier }, $kind, $length }, |;
     }
     say $tokfh '};';
 }
@@ -229,4 +266,63 @@ for my $state (@keys) {
 }
 say $tokfh '};';
 
+# Fifth step: Generate a switch on the first character of the input for every
+# state. It returns the indexes of the tokens which can match at all, in the
+# order in which they have to be tried: all tokens which are not literals (or
+# empty literals) and the literals starting with that character (ignoring
+# case).
+
+say $tokfh '';
+say $tokfh 'static const uint8_t *GENERATED_candidates(const cmdp_state state, const unsigned char c, int *n) {';
+say $tokfh '    switch (state) {';
+for my $state (@keys) {
+    my $tokens = $states{$state};
+    die qq|Too many tokens in state $state| if @$tokens > 255;
+
+    # Lowercased first character => indexes of the tokens to try.
+    my %by_char;
+    my @others;
+    for my $token (@$tokens) {
+        my ($literal) = ($token->{token} =~ /^'(.*)'$/);
+        $by_char{lc(substr($literal, 0, 1))} = [] if defined($literal) && $literal ne '';
+    }
+    for my $idx (0 .. $#$tokens) {
+        my ($literal) = ($tokens->[$idx]->{token} =~ /^'(.*)'$/);
+        # An empty literal matches before any character, just like the tokens
+        # which are not literals.
+        if (defined($literal) && $literal ne '') {
+            push @{$by_char{lc(substr($literal, 0, 1))}}, $idx;
+        } else {
+            push @others, $idx;
+            push @{$by_char{$_}}, $idx for keys %by_char;
+        }
+    }
+
+    say $tokfh "        case $state: {";
+    for my $char (sort keys %by_char) {
+        say $tokfh '            static const uint8_t first_' . ord($char) . '[] = {' . join(', ', @{$by_char{$char}}) . '};';
+    }
+    say $tokfh '            static const uint8_t others[] = {' . join(', ', @others) . '};' if @others > 0;
+    if (keys %by_char > 0) {
+        say $tokfh '            switch (c) {';
+        for my $char (sort keys %by_char) {
+            # Use numbers for the labels to not have to escape anything.
+            my @labels = (ord($char));
+            push @labels, ord(uc($char)) if uc($char) ne $char;
+            say $tokfh "                case $_:" for @labels;
+            say $tokfh '                    *n = ' . scalar @{$by_char{$char}} . ';';
+            say $tokfh '                    return first_' . ord($char) . ';';
+        }
+        say $tokfh '            }';
+    }
+    say $tokfh '            *n = ' . scalar @others . ';';
+    say $tokfh '            return ' . (@others > 0 ? 'others' : 'NULL') . ';';
+    say $tokfh '        }';
+}
+say $tokfh '        default:';
+say $tokfh '            *n = 0;';
+say $tokfh '            return NULL;';
+say $tokfh '    }';
+say $tokfh '}';
+
 close($tokfh);
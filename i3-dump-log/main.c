@@ -23,51 +23,206 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <time.h>
+#include <locale.h>
+#include <inttypes.h>
+#include <pthread.h>
 
 #include "libi3.h"
 #include "shmlog.h"
 #include <i3/ipc.h>
 
-static uint32_t offset_next_write,
-    wrap_count;
-
 static i3_shmlog_header *header;
-static char *logbuffer,
-    *walk;
-
-static int check_for_wrap(void) {
-    if (wrap_count == header->wrap_count)
-        return 0;
-
-    /* The log wrapped. Print the remaining content and reset walk to the top
-     * of the log. */
-    wrap_count = header->wrap_count;
-    const int len = (logbuffer + header->offset_last_wrap) - walk;
-    swrite(STDOUT_FILENO, walk, len);
-    walk = logbuffer + sizeof(i3_shmlog_header);
-    return 1;
+static char *logbuffer;
+
+/* The ringbuffer of the log, its size and the absolute offset (see
+ * i3_shmlog_header.head) up to which we have printed it. */
+static char *ring;
+static uint64_t ring_capacity,
+    read_pos;
+
+/* Where the log is written to, stdout unless -o was given. */
+static FILE *out;
+
+/* Text logs: Whether to skip everything up to the next newline. The first
+ * line we see after starting or after being lapped is incomplete. */
+static bool skip_partial_line;
+
+/* Binary logs: Sequence number of the next record we expect, to count the
+ * records we lost when i3 lapped us. */
+static uint64_t next_seq;
+static bool have_seq;
+
+/* Copy of the record currently being printed. i3 might overwrite the record
+ * in the SHM while we read it, so we only print the copy once we know that
+ * did not happen. */
+static char *record_copy;
+static size_t record_copy_size;
+
+/* In follow mode, new messages are written out after at most this long, even
+ * if we missed a wakeup (text logs) or i3 does not send any (binary logs). */
+#define FOLLOW_INTERVAL_NS (10 * 1000 * 1000)
+
+/*
+ * Returns whether the bytes starting at the given absolute offset were not
+ * overwritten by i3 (yet). Call this after copying them.
+ *
+ */
+static bool is_intact(uint64_t pos) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&(header->reserved), __ATOMIC_ACQUIRE) - pos <= ring_capacity;
 }
 
-static void print_till_end(void) {
-    check_for_wrap();
-    const int len = (logbuffer + header->offset_next_write) - walk;
-    swrite(STDOUT_FILENO, walk, len);
-    walk += len;
+static void report_lost(uint64_t count, const char *what) {
+    fprintf(out, "i3-dump-log: %" PRIu64 " %s lost, i3 overwrote them before they could be read\n",
+            count, what);
+}
+
+/*
+ * Prints the lines of a text log which were written since the last call.
+ *
+ */
+static void print_text(void) {
+    static char chunk[64 * 1024];
+    const uint64_t head = __atomic_load_n(&(header->head), __ATOMIC_ACQUIRE);
+    while (read_pos < head) {
+        const uint64_t pos = read_pos % ring_capacity;
+        size_t len = sizeof(chunk);
+        if (head - read_pos < len)
+            len = head - read_pos;
+        if (ring_capacity - pos < len)
+            len = ring_capacity - pos;
+        memcpy(chunk, ring + pos, len);
+        if (!is_intact(read_pos)) {
+            const uint64_t oldest = __atomic_load_n(&(header->reserved), __ATOMIC_ACQUIRE) - ring_capacity;
+            report_lost(oldest - read_pos, "bytes");
+            read_pos = oldest;
+            skip_partial_line = true;
+            continue;
+        }
+
+        const char *walk = chunk;
+        read_pos += len;
+        if (skip_partial_line) {
+            const char *newline = memchr(chunk, '\n', len);
+            if (newline == NULL)
+                continue;
+            skip_partial_line = false;
+            len -= (newline + 1 - chunk);
+            walk = newline + 1;
+        }
+        fwrite(walk, len, 1, out);
+    }
+}
+
+static void print_record(const i3_shmlog_record *record) {
+    const char *walk = (const char *)(record + 1);
+    const int64_t realtime = (int64_t)record->timestamp + header->realtime_offset;
+    const time_t t = realtime / 1000000000;
+    struct tm result;
+    char prefix[128];
+
+    if (have_seq && record->seq != next_seq)
+        report_lost(record->seq - next_seq, "records");
+    next_seq = record->seq + 1;
+    have_seq = true;
+
+    if (strftime(prefix, sizeof(prefix), "%x %X - ", localtime_r(&t, &result)) == 0)
+        prefix[0] = '\0';
+    fputs(prefix, out);
+    if (record->file_len > 0)
+        fprintf(out, "%.*s:%.*s:%u - ",
+                record->file_len, walk,
+                record->function_len, walk + record->file_len,
+                record->line);
+    walk += record->file_len + record->function_len;
+    fwrite(walk, record->message_len, 1, out);
+}
+
+/*
+ * Prints all records of a binary log which were published since the last
+ * call. Records i3 overwrote before we got to them are reported as lost.
+ *
+ */
+static void print_records(void) {
+    const uint64_t head = __atomic_load_n(&(header->head), __ATOMIC_ACQUIRE);
+    while (read_pos < head) {
+        const uint64_t pos = read_pos % ring_capacity;
+        const uint32_t len = i3_shmlog_record_length(ring, ring_capacity, pos);
+        const bool valid = (len > 0 && len <= ring_capacity - pos);
+        if (valid && len >= sizeof(i3_shmlog_record)) {
+            if (len > record_copy_size) {
+                record_copy_size = len;
+                record_copy = srealloc(record_copy, record_copy_size);
+            }
+            memcpy(record_copy, ring + pos, len);
+        }
+
+        /* If i3 started overwriting this record while we copied it, the copy
+         * is garbage. Continue with the oldest record which is intact, the
+         * gap in sequence numbers is reported when printing it. */
+        if (!valid || !is_intact(read_pos)) {
+            read_pos = __atomic_load_n(&(header->tail), __ATOMIC_ACQUIRE);
+            continue;
+        }
+
+        const i3_shmlog_record *record = (const i3_shmlog_record *)record_copy;
+        if (len >= sizeof(i3_shmlog_record) && record->level != I3_SHMLOG_LEVEL_PAD)
+            print_record(record);
+        read_pos += len;
+    }
+}
+
+static void flush_output(void) {
+    if (fflush(out) != 0)
+        err(EXIT_FAILURE, "Could not write the log");
+}
+
+/*
+ * Waits until i3 wrote something new or FOLLOW_INTERVAL_NS passed.
+ *
+ */
+static void wait_for_more(bool binary) {
+    if (binary) {
+        /* i3 does not broadcast the condvar for binary logs. */
+        const struct timespec interval = {0, FOLLOW_INTERVAL_NS};
+        nanosleep(&interval, NULL);
+        return;
+    }
+
+    /* Since pthread_cond_wait() expects a mutex, we need to provide one.
+     * To not lock i3 (that’s bad, mhkay?) we just define one outside of
+     * the shared memory. */
+    static pthread_mutex_t dummy_mutex = PTHREAD_MUTEX_INITIALIZER;
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += FOLLOW_INTERVAL_NS;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    pthread_mutex_lock(&dummy_mutex);
+    pthread_cond_timedwait(&(header->condvar), &dummy_mutex, &deadline);
+    pthread_mutex_unlock(&dummy_mutex);
 }
 
 int main(int argc, char *argv[]) {
     int o, option_index = 0;
     bool verbose = false,
          follow = false;
+    char *output_path = NULL;
 
     static struct option long_options[] = {
         {"version", no_argument, 0, 'v'},
         {"verbose", no_argument, 0, 'V'},
         {"follow", no_argument, 0, 'f'},
+        {"output", required_argument, 0, 'o'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}};
 
-    char *options_string = "s:vfVh";
+    char *options_string = "s:vfo:Vh";
+
+    setlocale(LC_ALL, "");
 
     while ((o = getopt_long(argc, argv, options_string, long_options, &option_index)) != -1) {
         if (o == 'v') {
@@ -77,9 +232,12 @@ int main(int argc, char *argv[]) {
             verbose = true;
         } else if (o == 'f') {
             follow = true;
+        } else if (o == 'o') {
+            free(output_path);
+            output_path = sstrdup(optarg);
         } else if (o == 'h') {
             printf("i3-dump-log " I3_VERSION "\n");
-            printf("i3-dump-log [-f] [-s <socket>]\n");
+            printf("i3-dump-log [-f] [-o <file>] [-s <socket>]\n");
             return 0;
         }
     }
@@ -136,45 +294,39 @@ int main(int argc, char *argv[]) {
     header = (i3_shmlog_header *)logbuffer;
 
     if (verbose)
-        printf("next_write = %d, last_wrap = %d, logbuffer_size = %d, shmname = %s\n",
-               header->offset_next_write, header->offset_last_wrap, header->size, shmname);
-    walk = logbuffer + header->offset_next_write;
-
-    /* We first need to print old content in case there was at least one
-     * wrapping already. */
-
-    if (*walk != '\0') {
-        /* In case there was a write to the buffer already, skip the first
-         * old line, it very likely is mangled. Not a problem, though, the log
-         * is chatty enough to have plenty lines left. */
-        while (*walk != '\n')
-            walk++;
-        walk++;
+        printf("head = %" PRIu64 ", reserved = %" PRIu64 ", logbuffer_size = %d, format = %d, shmname = %s\n",
+               header->head, header->reserved, header->size, header->format, shmname);
+
+    if (output_path == NULL) {
+        out = stdout;
+    } else if ((out = fopen(output_path, "a")) == NULL) {
+        err(EXIT_FAILURE, "Could not open %s", output_path);
     }
 
-    /* In case there was no wrapping, this is a no-op, otherwise it prints the
-     * old lines. */
-    wrap_count = 0;
-    check_for_wrap();
-
-    /* Then start from the beginning and print the newer lines */
-    walk = logbuffer + sizeof(i3_shmlog_header);
-    print_till_end();
-
-    if (follow) {
-        /* Since pthread_cond_wait() expects a mutex, we need to provide one.
-         * To not lock i3 (that’s bad, mhkay?) we just define one outside of
-         * the shared memory. */
-        pthread_mutex_t dummy_mutex = PTHREAD_MUTEX_INITIALIZER;
-        pthread_mutex_lock(&dummy_mutex);
-        while (1) {
-            pthread_cond_wait(&(header->condvar), &dummy_mutex);
-            /* If this was not a spurious wakeup, print the new lines. */
-            if (header->offset_next_write != offset_next_write) {
-                offset_next_write = header->offset_next_write;
-                print_till_end();
-            }
-        }
+    ring = logbuffer + I3_SHMLOG_DATA_OFFSET;
+    ring_capacity = i3_shmlog_capacity(header);
+
+    const bool binary = (__atomic_load_n(&(header->format), __ATOMIC_ACQUIRE) == I3_SHMLOG_FORMAT_BINARY);
+    if (binary) {
+        read_pos = __atomic_load_n(&(header->tail), __ATOMIC_ACQUIRE);
+    } else {
+        /* Start with the oldest byte i3 is not overwriting right now. Unless
+         * the log did not wrap yet, that is in the middle of a line. */
+        const uint64_t reserved = __atomic_load_n(&(header->reserved), __ATOMIC_ACQUIRE);
+        read_pos = (reserved > ring_capacity ? reserved - ring_capacity : 0);
+        skip_partial_line = (read_pos > 0);
+    }
+
+    while (1) {
+        if (binary)
+            print_records();
+        else
+            print_text();
+        flush_output();
+
+        if (!follow)
+            break;
+        wait_for_more(binary);
     }
 
     return 0;
@@ -155,9 +155,15 @@ int main(int argc, char *argv[]) {
                 message_type = I3_IPC_MESSAGE_TYPE_GET_BAR_CONFIG;
             else if (strcasecmp(optarg, "get_version") == 0)
                 message_type = I3_IPC_MESSAGE_TYPE_GET_VERSION;
+            else if (strcasecmp(optarg, "get_render_stats") == 0)
+                message_type = I3_IPC_MESSAGE_TYPE_GET_RENDER_STATS;
+            else if (strcasecmp(optarg, "run_commands") == 0)
+                message_type = I3_IPC_MESSAGE_TYPE_RUN_COMMANDS;
+            else if (strcasecmp(optarg, "get_x_stats") == 0)
+                message_type = I3_IPC_MESSAGE_TYPE_GET_X_STATS;
             else {
                 printf("Unknown message type\n");
-                printf("Known types: command, get_workspaces, get_outputs, get_tree, get_marks, get_bar_config, get_version\n");
+                printf("Known types: command, get_workspaces, get_outputs, get_tree, get_marks, get_bar_config, get_version, get_render_stats, run_commands, get_x_stats\n");
                 exit(EXIT_FAILURE);
             }
         } else if (o == 'q') {
@@ -228,7 +234,8 @@ int main(int argc, char *argv[]) {
         errx(EXIT_FAILURE, "IPC: Received reply of type %d but expected %d", reply_type, message_type);
     /* For the reply of commands, have a look if that command was successful.
      * If not, nicely format the error message. */
-    if (reply_type == I3_IPC_MESSAGE_TYPE_COMMAND) {
+    if (reply_type == I3_IPC_MESSAGE_TYPE_COMMAND ||
+        reply_type == I3_IPC_MESSAGE_TYPE_RUN_COMMANDS) {
         yajl_handle handle;
         handle = yajl_alloc(&reply_callbacks, NULL, NULL);
         yajl_status state = yajl_parse(handle, (const unsigned char *)reply, reply_length);
@@ -48,6 +48,8 @@ struct i3_output {
     xcb_pixmap_t buffer;  /* An extra pixmap for double-buffering */
     xcb_gcontext_t bargc; /* The graphical context of the bar */
 
+    text_renderer* text_renderer; /* Draws the text onto the buffer */
+
     struct ws_head* workspaces;  /* The workspaces on this output */
     struct tc_head* trayclients; /* The tray clients on this output */
 
@@ -152,6 +152,7 @@ static int outputs_start_map_cb(void *params_) {
         new_output->ws = 0,
         memset(&new_output->rect, 0, sizeof(rect));
         new_output->bar = XCB_NONE;
+        new_output->text_renderer = NULL;
 
         new_output->workspaces = smalloc(sizeof(struct ws_head));
         TAILQ_INIT(new_output->workspaces);
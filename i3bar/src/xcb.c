@@ -76,6 +76,7 @@ xcb_gcontext_t statusline_ctx;
 xcb_gcontext_t statusline_clear;
 xcb_pixmap_t statusline_pm;
 uint32_t statusline_width;
+static text_renderer *statusline_renderer;
 
 /* Event watchers, to interact with the user */
 ev_prepare *xcb_prep;
@@ -183,8 +184,8 @@ static void draw_separator(uint32_t x, struct status_block *block) {
         /* Draw a custom separator. */
         uint32_t separator_x = MAX(x - block->sep_block_width, center_x - separator_symbol_width / 2);
         set_font_colors(statusline_ctx, colors.sep_fg, colors.bar_bg);
-        draw_text(config.separator_symbol, statusline_pm, statusline_ctx,
-                  separator_x, bar_height / 2 - font.height / 2, x - separator_x);
+        text_renderer_draw(statusline_renderer, config.separator_symbol, statusline_ctx,
+                           separator_x, bar_height / 2 - font.height / 2, x - separator_x);
     }
 }
 
@@ -299,10 +300,10 @@ void refresh_statusline(bool use_short_text) {
         }
 
         set_font_colors(statusline_ctx, fg_color, colors.bar_bg);
-        draw_text(block->full_text, statusline_pm, statusline_ctx,
-                  x + block->x_offset + logical_px(1) + block->border_left,
-                  bar_height / 2 - font.height / 2,
-                  block->width - logical_px(1) - block->border_left - block->border_right);
+        text_renderer_draw(statusline_renderer, block->full_text, statusline_ctx,
+                           x + block->x_offset + logical_px(1) + block->border_left,
+                           bar_height / 2 - font.height / 2,
+                           block->width - logical_px(1) - block->border_left - block->border_right);
         x += block->width + block->sep_block_width + block->x_offset + block->x_append;
 
         /* If this is not the last block, draw a separator. */
@@ -1171,6 +1172,9 @@ char *init_xcb_early() {
                                                                xcb_root,
                                                                root_screen->width_in_pixels,
                                                                root_screen->height_in_pixels);
+    statusline_renderer = text_renderer_new(statusline_pm,
+                                            root_screen->width_in_pixels,
+                                            root_screen->height_in_pixels);
 
     /* The various watchers to communicate with xcb */
     xcb_io = smalloc(sizeof(ev_io));
@@ -1523,6 +1527,8 @@ void destroy_window(i3_output *output) {
     }
 
     kick_tray_clients(output);
+    text_renderer_free(output->text_renderer);
+    output->text_renderer = NULL;
     xcb_destroy_window(xcb_connection, output->bar);
     output->bar = XCB_NONE;
 }
@@ -1534,6 +1540,7 @@ void destroy_window(i3_output *output) {
 void realloc_sl_buffer(void) {
     DLOG("Re-allocating statusline buffer, statusline_width = %d, root_screen->width_in_pixels = %d\n",
          statusline_width, root_screen->width_in_pixels);
+    text_renderer_free(statusline_renderer);
     xcb_free_pixmap(xcb_connection, statusline_pm);
     statusline_pm = xcb_generate_id(xcb_connection);
     xcb_void_cookie_t sl_pm_cookie = xcb_create_pixmap_checked(xcb_connection,
@@ -1542,6 +1549,9 @@ void realloc_sl_buffer(void) {
                                                                xcb_root,
                                                                MAX(root_screen->width_in_pixels, statusline_width),
                                                                bar_height);
+    statusline_renderer = text_renderer_new(statusline_pm,
+                                            MAX(root_screen->width_in_pixels, statusline_width),
+                                            bar_height);
 
     uint32_t mask = XCB_GC_FOREGROUND;
     uint32_t vals[2] = {colors.bar_bg, colors.bar_bg};
@@ -1676,6 +1686,7 @@ void reconfig_windows(bool redraw_bars) {
                                                                     walk->bar,
                                                                     walk->rect.w,
                                                                     bar_height);
+            walk->text_renderer = text_renderer_new(walk->buffer, walk->rect.w, bar_height);
 
             /* Set the WM_CLASS and WM_NAME (we don't need UTF-8) atoms */
             xcb_void_cookie_t class_cookie;
@@ -1777,6 +1788,7 @@ void reconfig_windows(bool redraw_bars) {
             xcb_void_cookie_t strut_cookie = config_strut_partial(walk);
 
             DLOG("Destroying buffer for output %s\n", walk->name);
+            text_renderer_free(walk->text_renderer);
             xcb_free_pixmap(xcb_connection, walk->buffer);
 
             DLOG("Reconfiguring window for output %s to %d,%d\n", walk->name, values[0], values[1]);
@@ -1800,6 +1812,7 @@ void reconfig_windows(bool redraw_bars) {
                                                                     walk->bar,
                                                                     walk->rect.w,
                                                                     bar_height);
+            walk->text_renderer = text_renderer_new(walk->buffer, walk->rect.w, bar_height);
 
             xcb_void_cookie_t map_cookie, umap_cookie;
             if (redraw_bars) {
@@ -1924,10 +1937,10 @@ void draw_bars(bool unhide) {
                                         1,
                                         &rect);
                 set_font_colors(outputs_walk->bargc, fg_color, bg_color);
-                draw_text(ws_walk->name, outputs_walk->buffer, outputs_walk->bargc,
-                          workspace_width + logical_px(ws_hoff_px) + logical_px(1),
-                          bar_height / 2 - font.height / 2,
-                          ws_walk->name_width);
+                text_renderer_draw(outputs_walk->text_renderer, ws_walk->name, outputs_walk->bargc,
+                                   workspace_width + logical_px(ws_hoff_px) + logical_px(1),
+                                   bar_height / 2 - font.height / 2,
+                                   ws_walk->name_width);
 
                 workspace_width += 2 * logical_px(ws_hoff_px) + 2 * logical_px(1) + ws_walk->name_width;
                 if (TAILQ_NEXT(ws_walk, tailq) != NULL)
@@ -1967,7 +1980,7 @@ void draw_bars(bool unhide) {
                                     &rect);
 
             set_font_colors(outputs_walk->bargc, fg_color, bg_color);
-            draw_text(binding.name, outputs_walk->buffer, outputs_walk->bargc, workspace_width + logical_px(ws_hoff_px) + logical_px(1), bar_height / 2 - font.height / 2, binding.width);
+            text_renderer_draw(outputs_walk->text_renderer, binding.name, outputs_walk->bargc, workspace_width + logical_px(ws_hoff_px) + logical_px(1), bar_height / 2 - font.height / 2, binding.width);
 
             unhide = true;
             workspace_width += 2 * logical_px(ws_hoff_px) + 2 * logical_px(1) + binding.width;
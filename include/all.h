@@ -61,6 +61,8 @@
 #include "randr.h"
 #include "xinerama.h"
 #include "con.h"
+#include "con_index.h"
+#include "tree_diff.h"
 #include "load_layout.h"
 #include "render.h"
 #include "window.h"
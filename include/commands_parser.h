@@ -65,3 +65,44 @@ CommandResult *parse_command(const char *input, yajl_gen gen);
  * Frees a CommandResult
  */
 void command_result_free(CommandResult *result);
+
+/**
+ * A command which was parsed in advance by command_program_new(), so that it
+ * can be executed repeatedly without parsing it again.
+ */
+typedef struct CommandProgram CommandProgram;
+
+/**
+ * Parses the given command into a program which command_program_run() can
+ * execute any number of times without parsing the command again. Returns
+ * NULL if the command cannot be parsed, use parse_command() to report the
+ * error in that case.
+ *
+ * Must not be called while a command is being executed, since the parser
+ * state is shared with parse_command().
+ *
+ */
+CommandProgram *command_program_new(const char *input);
+
+/**
+ * Executes the given program like parse_command() would execute its command
+ * (without generating a JSON reply). If con is not NULL, the command is
+ * executed with that container selected, like a [con_id=…] prefix would.
+ *
+ * Free the returned CommandResult with command_result_free().
+ *
+ */
+CommandResult *command_program_run(CommandProgram *program, Con *con);
+
+/**
+ * Returns a new reference to the given program (which may be NULL).
+ *
+ */
+CommandProgram *command_program_ref(CommandProgram *program);
+
+/**
+ * Drops a reference to the given program, freeing it once it is no longer
+ * referenced.
+ *
+ */
+void command_program_free(CommandProgram *program);
@@ -140,6 +140,19 @@ Con *con_by_frame_id(xcb_window_t frame);
  */
 Con *con_by_mark(const char *mark);
 
+/**
+ * Assigns the given mark to the container. Since marks are unique, the mark is
+ * removed from any other container which currently has it.
+ *
+ */
+void con_mark(Con *con, const char *mark);
+
+/**
+ * Removes the mark of the given container, if it has one.
+ *
+ */
+void con_unmark(Con *con);
+
 /**
  * Returns the first container below 'con' which wants to swallow this window
  * TODO: priority
@@ -397,6 +410,14 @@ gaps_t calculate_effective_gaps(Con *con);
  */
 void con_force_split_parents_redraw(Con *con);
 
+/**
+ * Marks the workspace containing the given container as dirty, so that the
+ * next render recomputes the gaps of its containers instead of using the
+ * cached ones. Containers outside of a workspace invalidate the whole tree.
+ *
+ */
+void con_invalidate(Con *con);
+
 /**
  * Recursively check whether the (potential) parent container
  * contains the (potential) child container.
@@ -0,0 +1,74 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * con_index.c: Hash indexes which map X11 window IDs (client windows and
+ *              frames) and marks to their containers, so that looking up the
+ *              container for an X11 event or a mark does not require walking
+ *              all_cons.
+ *
+ */
+#pragma once
+
+/**
+ * Adds the client window of the given container to the window index. Has to
+ * be called whenever con->window is set.
+ *
+ */
+void con_index_add_window(Con *con);
+
+/**
+ * Removes the client window of the given container from the window index.
+ * Has to be called before con->window is freed or handed to another
+ * container.
+ *
+ */
+void con_index_remove_window(Con *con);
+
+/**
+ * Adds the frame of the given container to the frame index. Called from
+ * x_con_init() once the frame has been created.
+ *
+ */
+void con_index_add_frame(Con *con);
+
+/**
+ * Removes the frame of the given container from the frame index. Called from
+ * x_con_kill() when the frame is destroyed.
+ *
+ */
+void con_index_remove_frame(Con *con);
+
+/**
+ * Adds the mark of the given container to the mark index. Called from
+ * con_mark().
+ *
+ */
+void con_index_add_mark(Con *con);
+
+/**
+ * Removes the mark of the given container from the mark index. Has to be
+ * called before con->mark is freed.
+ *
+ */
+void con_index_remove_mark(Con *con);
+
+/**
+ * Returns the container whose client window has the given ID or NULL.
+ *
+ */
+Con *con_index_get_by_window(xcb_window_t window);
+
+/**
+ * Returns the container whose frame has the given ID or NULL.
+ *
+ */
+Con *con_index_get_by_frame(xcb_window_t frame);
+
+/**
+ * Returns the container with the given mark or NULL.
+ *
+ */
+Con *con_index_get_by_mark(const char *mark);
@@ -171,6 +171,11 @@ struct Config {
       * This can prevent i3 from exiting when all outputs disappear momentarily. */
     float zero_disp_exit_timer_ms;
 
+    /** Maximum number of bytes which may be queued for an IPC client that
+     * does not read its replies and events. Clients exceeding it are
+     * disconnected. */
+    size_t ipc_buffer_limit;
+
     /** Behavior when a window sends a NET_ACTIVE_WINDOW message. */
     enum {
         /* Focus if the target workspace is visible, set urgency hint otherwise. */
@@ -196,11 +196,22 @@ struct Workspace_Assignment {
 };
 
 struct Ignore_Event {
+    /* Only the lower 16 bits, as contained in X11 events. */
     int sequence;
     int response_type;
-    time_t added;
-
-    SLIST_ENTRY(Ignore_Event) ignore_events;
+    /* ev_now() when the event was added. */
+    double added;
+
+    /* Only set for requests whose error is expected, see
+     * add_watched_request(): the full sequence number and the window the
+     * request is about. */
+    unsigned int full_sequence;
+    xcb_window_t window;
+
+    /* The hash bucket, see event_is_ignored(). */
+    LIST_ENTRY(Ignore_Event) ignore_events;
+    /* All ignored events, oldest first. */
+    TAILQ_ENTRY(Ignore_Event) ignore_order;
 };
 
 /**
@@ -230,11 +241,40 @@ struct Startup_Sequence {
  * This makes it easier to have a useful logfile, including the matching or
  * non-matching pattern.
  *
+ * regex_new() hands out shared, reference counted instances from a cache, see
+ * regex.c. They must only be released with regex_free().
+ *
  */
 struct regex {
     char *pattern;
     pcre *regex;
     pcre_extra *extra;
+
+    /* Patterns without any metacharacters (apart from a leading ^ and a
+     * trailing $) are matched with string functions instead of pcre_exec(). */
+    enum {
+        RE_LITERAL_NONE = 0,
+        /* foo */
+        RE_LITERAL_CONTAINS,
+        /* ^foo */
+        RE_LITERAL_PREFIX,
+        /* foo$ */
+        RE_LITERAL_SUFFIX,
+        /* ^foo$ */
+        RE_LITERAL_EXACT
+    } literal_type;
+    /* The literal text of the pattern, without the anchors. */
+    char *literal;
+    size_t literal_len;
+
+    /* Number of users (Matches) of this regex. Unused regexes stay in the
+     * cache for a while, so that the next command using the same criteria
+     * does not need to compile them again. */
+    int refcount;
+    uint32_t hash;
+
+    SLIST_ENTRY(regex) cache_entries;
+    TAILQ_ENTRY(regex) unused_regexes;
 };
 
 /******************************************************************************
@@ -298,6 +338,13 @@ struct Binding {
     /** Command, like in command mode */
     char *command;
 
+    /** The parsed command, see command_program_new(). NULL until the binding
+     * is run for the first time or if the command cannot be parsed. */
+    struct CommandProgram *program;
+
+    /** Set once parsing the command failed, so that it is not tried again. */
+    bool program_failed;
+
     TAILQ_ENTRY(Binding) bindings;
 };
 
@@ -536,6 +583,15 @@ struct Con {
     xcb_window_t frame;
     xcb_pixmap_t pixmap;
     xcb_gcontext_t pm_gc;
+    /* The pre-rendered title bar, see x_draw_decoration() */
+    struct deco_strip *deco_strip;
+    /* X11 state of the frame window, see x.c */
+    struct con_state *state;
+    /* TC_* bits of the properties which changed since the last "tree" IPC
+     * event, and whether this container was reported at all, see
+     * tree_diff.c */
+    int tree_changes;
+    bool tree_reported;
 
     enum {
         CT_ROOT = 0,
@@ -553,6 +609,20 @@ struct Con {
     /** Only applicable for containers of type CT_WORKSPACE. */
     gaps_t gaps;
 
+    /** Set by con_invalidate() when something changed which influences the
+     * gaps of the containers on this workspace (only applicable for
+     * containers of type CT_WORKSPACE; for CT_ROOT, it means the whole tree).
+     * Cleared by tree_render() once the workspace was rendered. */
+    bool dirty;
+    /** The value of render_stats.frames when this workspace was last
+     * rendered by tree_render(). */
+    uint64_t render_frame;
+
+    /* The gaps inset render_con() computed for this container, re-used as
+     * long as its workspace is not dirty. */
+    bool inset_valid;
+    struct Rect inset;
+
     struct Con *parent;
 
     struct Rect rect;
@@ -639,7 +709,9 @@ struct Con {
     TAILQ_ENTRY(Con) nodes;
     TAILQ_ENTRY(Con) focused;
     TAILQ_ENTRY(Con) all_cons;
+    TAILQ_ENTRY(Con) marked_cons;
     TAILQ_ENTRY(Con) floating_windows;
+    TAILQ_ENTRY(Con) tree_changed;
 
     /** callbacks */
     void (*on_remove_child)(Con *);
@@ -31,6 +31,22 @@ void add_ignore_event(const int sequence, const int response_type);
  */
 bool event_is_ignored(const int sequence, const int response_type);
 
+/**
+ * Remembers that the request with the given sequence number was sent for the
+ * given window and may fail, see watched_request_failed(). Like ignored
+ * events, entries are garbage collected after 5 seconds.
+ *
+ */
+void add_watched_request(const unsigned int sequence, const xcb_window_t window);
+
+/**
+ * Returns the window of the watched request with the given (full) sequence
+ * number and forgets about the request, or XCB_NONE if the request was not
+ * watched.
+ *
+ */
+xcb_window_t watched_request_failed(const unsigned int full_sequence);
+
 /**
  * Takes an xcb_generic_event_t and calls the appropriate handler, based on the
  * event type.
@@ -45,6 +61,14 @@ void handle_event(int type, xcb_generic_event_t *event);
  */
 void property_handlers_init(void);
 
+/**
+ * Handles the property replies which arrived and sends the requests for the
+ * properties which changed since the last call. Called before the event loop
+ * blocks, i.e. once per batch of events.
+ *
+ */
+void handle_pending_properties(void);
+
 #if 0
 /**
  * Configuration notifies are only handled because we need to set up ignore
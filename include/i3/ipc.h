@@ -51,6 +51,15 @@ typedef struct i3_ipc_header {
 /** Request the i3 version */
 #define I3_IPC_MESSAGE_TYPE_GET_VERSION 7
 
+/** Request statistics about the last render */
+#define I3_IPC_MESSAGE_TYPE_GET_RENDER_STATS 8
+
+/** Execute several commands, rendering the tree only once */
+#define I3_IPC_MESSAGE_TYPE_RUN_COMMANDS 9
+
+/** Request statistics about the X11 requests sent while rendering */
+#define I3_IPC_MESSAGE_TYPE_GET_X_STATS 10
+
 /*
  * Messages from i3 to clients
  *
@@ -80,6 +89,15 @@ typedef struct i3_ipc_header {
 /** i3 version reply type */
 #define I3_IPC_REPLY_TYPE_VERSION 7
 
+/** Render statistics reply type */
+#define I3_IPC_REPLY_TYPE_RENDER_STATS 8
+
+/** Reply type for RUN_COMMANDS */
+#define I3_IPC_REPLY_TYPE_RUN_COMMANDS 9
+
+/** X11 request statistics reply type */
+#define I3_IPC_REPLY_TYPE_X_STATS 10
+
 /*
  * Events from i3 to clients. Events have the first bit set high.
  *
@@ -103,3 +121,10 @@ typedef struct i3_ipc_header {
 
 /** The binding event will be triggered when bindings run */
 #define I3_IPC_EVENT_BINDING (I3_IPC_EVENT_MASK | 5)
+
+/** The tree event will be triggered with the containers which changed since
+ * the last tree event */
+#define I3_IPC_EVENT_TREE (I3_IPC_EVENT_MASK | 6)
+
+/** Number of event types, i.e. the lowest unused event number */
+#define I3_IPC_EVENT_COUNT 7
@@ -25,9 +25,27 @@ extern char *current_socketpath;
 typedef struct ipc_client {
     int fd;
 
-    /* The events which this client wants to receive */
-    int num_events;
-    char **events;
+    /* The events which this client wants to receive: bit n is set if the
+     * client is subscribed to the event (I3_IPC_EVENT_MASK | n). */
+    uint32_t events;
+
+    struct ev_io *read_callback;
+    /* Only active while there is queued output for this client. */
+    struct ev_io *write_callback;
+
+    /* Ring buffer of replies and events which could not be written to the
+     * socket without blocking yet. buffer_len bytes starting at buffer_start
+     * (wrapping around at buffer_size) are queued. */
+    uint8_t *buffer;
+    size_t buffer_size;
+    size_t buffer_start;
+    size_t buffer_len;
+
+    /* Set when the connection was shut down because of a write error or
+     * because the client exceeded ipc_buffer_limit. Nothing is sent to
+     * dropped clients anymore. The client is freed as soon as the read
+     * watcher notices the closed connection. */
+    bool dropped;
 
     TAILQ_ENTRY(ipc_client) clients;
 } ipc_client;
@@ -42,12 +60,12 @@ typedef struct ipc_client {
  * message_type is the type of the message as the sender specified it.
  *
  */
-typedef void (*handler_t)(int, uint8_t *, int, uint32_t, uint32_t);
+typedef void (*handler_t)(ipc_client *, uint8_t *, int, uint32_t, uint32_t);
 
 /* Macro to declare a callback */
-#define IPC_HANDLER(name)                                      \
-    static void handle_##name(int fd, uint8_t *message,        \
-                              int size, uint32_t message_size, \
+#define IPC_HANDLER(name)                                           \
+    static void handle_##name(ipc_client *client, uint8_t *message, \
+                              int size, uint32_t message_size,      \
                               uint32_t message_type)
 
 /**
@@ -73,6 +91,14 @@ int ipc_create_socket(const char *filename);
  */
 void ipc_send_event(const char *event, uint32_t message_type, const char *payload);
 
+/**
+ * Returns true if at least one IPC client is subscribed to the given event
+ * type (one of the I3_IPC_EVENT_* constants). Callers use this to avoid
+ * generating the payload of events nobody is interested in.
+ *
+ */
+bool ipc_has_event_subscribers(uint32_t message_type);
+
 /**
  * Calls shutdown() on each socket and closes it. This function to be called
  * when exiting or restarting only!
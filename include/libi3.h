@@ -29,6 +29,13 @@ typedef struct _i3String i3String;
 
 typedef struct Font i3Font;
 
+/**
+ * Opaque data structure for drawing text onto one drawable, see
+ * text_renderer_new().
+ *
+ */
+typedef struct text_renderer text_renderer;
+
 /**
  * Data structure for cached font information:
  * - font id in X11 (load it once)
@@ -410,6 +417,32 @@ void draw_text(i3String *text, xcb_drawable_t drawable,
 void draw_text_ascii(const char *text, xcb_drawable_t drawable,
                      xcb_gcontext_t gc, int x, int y, int max_width);
 
+/**
+ * Creates a text renderer for the given drawable, which has to be of the
+ * given size and use the visual of the root window.
+ *
+ * When using a Pango font, draw_text() creates a cairo surface and a Pango
+ * layout for every string. A text renderer creates them once and only resets
+ * the text, which is much cheaper when drawing many strings onto the same
+ * drawable (tabs, i3bar blocks).
+ *
+ */
+text_renderer *text_renderer_new(xcb_drawable_t drawable, int width, int height);
+
+/**
+ * Frees the given text renderer (which may be NULL). Has to be called before
+ * its drawable is freed.
+ *
+ */
+void text_renderer_free(text_renderer *renderer);
+
+/**
+ * Draws text onto the drawable of the given renderer, just like draw_text().
+ *
+ */
+void text_renderer_draw(text_renderer *renderer, i3String *text,
+                        xcb_gcontext_t gc, int x, int y, int max_width);
+
 /**
  * Predict the text width in pixels for the given text. Text must be
  * specified as an i3String.
@@ -417,6 +450,13 @@ void draw_text_ascii(const char *text, xcb_drawable_t drawable,
  */
 int predict_text_width(i3String *text);
 
+/**
+ * Returns the number of hits and misses of the text width cache used by
+ * predict_text_width().
+ *
+ */
+void text_width_cache_stats(uint64_t *hits, uint64_t *misses);
+
 /**
  * Returns the visual type associated with the given screen.
  *
@@ -25,14 +25,40 @@
 #endif
 /** ##__VA_ARGS__ means: leave out __VA_ARGS__ completely if it is empty, that
    is, delete the preceding comma */
-#define LOG(fmt, ...) verboselog(fmt, ##__VA_ARGS__)
+/** LOG() and DLOG() check a global before calling into log.c, so that their
+   arguments are not evaluated at all when nothing would be logged. Building
+   with -DI3_NO_DEBUG_LOG (make NO_DEBUG_LOG=1) removes DLOG() entirely. */
+#define LOG(fmt, ...)                       \
+    do {                                    \
+        if (verboselog_enabled)             \
+            verboselog(fmt, ##__VA_ARGS__); \
+    } while (0)
 #define ELOG(fmt, ...) errorlog("ERROR: " fmt, ##__VA_ARGS__)
-#define DLOG(fmt, ...) debuglog("%s:%s:%d - " fmt, I3__FILE__, __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#if defined(I3_NO_DEBUG_LOG)
+/* Keep the call in dead code so that the format string is still checked. */
+#define DLOG(fmt, ...)                                                           \
+    do {                                                                         \
+        if (0)                                                                   \
+            debuglog_at(I3__FILE__, __FUNCTION__, __LINE__, fmt, ##__VA_ARGS__); \
+    } while (0)
+#else
+#define DLOG(fmt, ...)                                                           \
+    do {                                                                         \
+        if (debuglog_enabled)                                                    \
+            debuglog_at(I3__FILE__, __FUNCTION__, __LINE__, fmt, ##__VA_ARGS__); \
+    } while (0)
+#endif
 
 extern char *errorfilename;
 extern char *shmlogname;
 extern int shmlog_size;
 
+/* Whether verboselog() / debuglog() would log anything, that is whether
+ * verbose / debug logging or the SHM log is enabled. Kept up to date by
+ * log.c, read by LOG() and DLOG(). */
+extern bool verboselog_enabled;
+extern bool debuglog_enabled;
+
 /**
  * Initializes logging by creating an error logfile in /tmp (or
  * XDG_RUNTIME_DIR, see get_process_filename()).
@@ -64,6 +90,13 @@ bool get_debug_logging(void);
  */
 void set_debug_logging(const bool _debug_logging);
 
+/**
+ * Switches the SHM log between text lines and binary records. If the SHM log
+ * is already open, it is re-opened in the new format.
+ *
+ */
+void set_shmlog_binary(bool binary);
+
 /**
  * Set verbosity of i3. If verbose is set to true, informative messages will
  * be printed to stdout. If verbose is set to false, only errors will be
@@ -80,6 +113,14 @@ void set_verbosity(bool _verbose);
 void debuglog(char *fmt, ...)
     __attribute__((format(printf, 1, 2)));
 
+/**
+ * Like debuglog(), but passes the source location separately so that the
+ * binary SHM log can store it without formatting it.
+ *
+ */
+void debuglog_at(const char *file, const char *function, int line, char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
 /**
  * Logs the given message to stdout while prefixing the current time to it.
  *
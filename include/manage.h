@@ -36,6 +36,15 @@ void manage_window(xcb_window_t window,
                    xcb_get_window_attributes_cookie_t cookie,
                    bool needs_to_be_mapped);
 
+/**
+ * Handles an X11 error for one of the requests sent while managing a window.
+ * Such an error means that the window was destroyed before we could set our
+ * event mask or reparent it, so it is unmanaged again. Returns false if the
+ * error does not belong to such a request.
+ *
+ */
+bool manage_handle_error(xcb_generic_error_t *error);
+
 #if 0
 /**
  * reparent_window() gets called when a new window was opened and becomes a
@@ -15,6 +15,9 @@
  * most likely be used often (like for every new window and on every relevant
  * property change of existing windows).
  *
+ * Regexes are cached by pattern and shared, so this only compiles a pattern
+ * the first time it is seen (or when it was unused for a while).
+ *
  * Returns NULL if the pattern could not be compiled into a regular expression
  * (and ELOGs an appropriate error message).
  *
@@ -22,7 +25,7 @@
 struct regex *regex_new(const char *pattern);
 
 /**
- * Frees the given regular expression. It must not be used afterwards!
+ * Releases the given regular expression. It must not be used afterwards!
  *
  */
 void regex_free(struct regex *regex);
@@ -10,6 +10,25 @@
  */
 #pragma once
 
+/**
+ * Counters about the work done by tree_render(), exposed via the
+ * GET_RENDER_STATS IPC request.
+ *
+ */
+struct render_stats {
+    /** Number of frames rendered by tree_render() so far. */
+    uint64_t frames;
+    /** Number of containers rendered in the last frame. Every frame computes
+     * the rects of all containers on visible workspaces. */
+    uint32_t rendered;
+    /** Number of containers in the last frame whose gaps were recomputed
+     * (because their workspace was dirty or they were new) instead of
+     * re-using the cached ones. Containers without gaps are not counted. */
+    uint32_t gaps_recomputed;
+};
+
+extern struct render_stats render_stats;
+
 /**
  * "Renders" the given container (and its children), meaning that all rects are
  * updated correctly. Note that this function does not call any xcb_*
@@ -16,15 +16,34 @@
 /* Default shmlog size if not set by user. */
 extern const int default_shmlog_size;
 
+/* Layout of the data following the i3_shmlog_header. */
+enum {
+    /* Formatted text lines. A line which does not fit at the end of the
+     * ringbuffer is continued at its beginning. */
+    I3_SHMLOG_FORMAT_TEXT = 0,
+    /* i3_shmlog_record entries, see tail. */
+    I3_SHMLOG_FORMAT_BINARY = 1
+};
+
+/* Levels of an i3_shmlog_record. */
+enum {
+    /* Filler up to the end of the ringbuffer, to be skipped by readers. */
+    I3_SHMLOG_LEVEL_PAD = 0,
+    I3_SHMLOG_LEVEL_ERROR = 1,
+    I3_SHMLOG_LEVEL_VERBOSE = 2,
+    I3_SHMLOG_LEVEL_DEBUG = 3
+};
+
 /*
  * Header of the shmlog file. Used by i3/src/log.c and i3/i3-dump-log/main.c.
  *
  */
 typedef struct i3_shmlog_header {
-    /* Byte offset where the next line will be written to. */
+    /* Byte offset where the next line will be written to. Superseded by
+     * head, which readers can use to detect that they were lapped. */
     uint32_t offset_next_write;
 
-    /* Byte offset where the last wrap occured. */
+    /* Byte offset of the end of the ringbuffer. */
     uint32_t offset_last_wrap;
 
     /* The size of the logfile in bytes. Since the size is limited to 25 MiB
@@ -38,7 +57,79 @@ typedef struct i3_shmlog_header {
     uint32_t wrap_count;
 
     /* pthread condvar which will be broadcasted whenever there is a new
-     * message in the log. i3-dump-log uses this to implement -f (follow, like
-     * tail -f) in an efficient way. */
+     * message in a text log. i3-dump-log uses this to implement -f (follow,
+     * like tail -f) in an efficient way. */
     pthread_cond_t condvar;
+
+    /* One of I3_SHMLOG_FORMAT_*. */
+    uint32_t format;
+
+    /* Number of records written so far (binary format only). */
+    uint64_t seq;
+
+    /* Absolute byte offsets into the ringbuffer, i.e. they never wrap. The
+     * position within the ringbuffer (which starts at I3_SHMLOG_DATA_OFFSET)
+     * is the offset modulo i3_shmlog_capacity().
+     *
+     * head is the end of the newest complete line or record. Before writing,
+     * i3 advances reserved to the end of what it is about to write, so a
+     * reader which copied bytes starting at offset p can check that
+     * reserved - p <= capacity afterwards to know they were not overwritten
+     * in the meantime. No locks are involved.
+     *
+     * tail (binary format only) is the oldest record which is still intact.
+     * Text readers start at reserved - capacity and skip the partial line. */
+    uint64_t head;
+    uint64_t tail;
+    uint64_t reserved;
+
+    /* CLOCK_REALTIME - CLOCK_MONOTONIC (in nanoseconds) when the log was
+     * opened. Add it to a record timestamp to get the wall clock time. */
+    int64_t realtime_offset;
 } i3_shmlog_header;
+
+/*
+ * A record of the binary shmlog. It is followed by file_len bytes of the
+ * file name, function_len bytes of the function name and message_len bytes
+ * of the formatted message, neither of them NUL-terminated.
+ *
+ */
+typedef struct i3_shmlog_record {
+    /* Length of the record in bytes, including this struct and the padding
+     * which aligns the next record to 8 bytes. */
+    uint32_t length;
+    /* Line number of the log call, or 0 if unknown. */
+    uint32_t line;
+    /* Sequence number, see i3_shmlog_header.seq. */
+    uint64_t seq;
+    /* CLOCK_MONOTONIC in nanoseconds. */
+    uint64_t timestamp;
+    /* One of I3_SHMLOG_LEVEL_*. */
+    uint16_t level;
+    uint16_t file_len;
+    uint16_t function_len;
+    uint16_t message_len;
+} i3_shmlog_record;
+
+/* Byte offset of the ringbuffer within the shmlog. */
+#define I3_SHMLOG_DATA_OFFSET ((sizeof(i3_shmlog_header) + 7) & ~(size_t)7)
+
+/*
+ * Returns the size of the ringbuffer of a shmlog.
+ *
+ */
+static inline uint64_t i3_shmlog_capacity(const i3_shmlog_header *header) {
+    return (header->size - I3_SHMLOG_DATA_OFFSET) & ~(uint64_t)7;
+}
+
+/*
+ * Returns the length of the record starting at the given ring position
+ * (offset modulo capacity). The last few bytes of the ring are skipped
+ * implicitly when they cannot hold a record header.
+ *
+ */
+static inline uint32_t i3_shmlog_record_length(const char *data, uint64_t capacity, uint64_t pos) {
+    if (capacity - pos < sizeof(i3_shmlog_record))
+        return capacity - pos;
+    return ((const i3_shmlog_record *)(data + pos))->length;
+}
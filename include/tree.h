@@ -15,6 +15,9 @@ extern Con *croot;
 extern Con *focused;
 TAILQ_HEAD(all_cons_head, Con);
 extern struct all_cons_head all_cons;
+/* All containers which currently carry a mark (see con_mark()). */
+TAILQ_HEAD(marked_cons_head, Con);
+extern struct marked_cons_head marked_cons;
 
 /**
  * Initializes the tree by creating the root node, adding all RandR outputs
@@ -56,6 +59,33 @@ bool level_down(void);
  */
 void tree_render(void);
 
+/**
+ * Marks the tree as needing a render. The render itself happens once, in
+ * tree_render_pending(), before the event loop blocks again, no matter how
+ * many events of the current batch requested one.
+ *
+ * Code which relies on the X11 state being up to date right away (e.g. before
+ * warping the pointer, during a drag or before replying to a client) has to
+ * call tree_render() directly instead.
+ *
+ */
+void tree_request_render(void);
+
+/**
+ * Like tree_request_render(), but only the changes to already rendered
+ * containers (e.g. a new window title) need to be pushed to X11, see
+ * x_push_changes().
+ *
+ */
+void tree_request_push(void);
+
+/**
+ * Performs the render requested by tree_request_render() or
+ * tree_request_push(), if any. Called from the event loop before it blocks.
+ *
+ */
+void tree_render_pending(void);
+
 /**
  * Closes the current container using tree_close().
  *
@@ -0,0 +1,70 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * tree_diff.c: Collects per-container deltas of the layout tree between two
+ *              pushes to X11 and sends them as "tree" IPC events, so that
+ *              clients do not need to poll GET_TREE.
+ *
+ */
+#pragma once
+
+/** Number of "tree" events sent so far. Included in GET_TREE replies so that
+ * clients can tell which events are already reflected in a tree they
+ * requested. */
+extern uint64_t tree_generation;
+
+/** Properties of a container which are reported in "tree" events, see
+ * tree_diff_changed(). */
+enum {
+    TC_PARENT = (1 << 0),
+    TC_TYPE = (1 << 1),
+    TC_NAME = (1 << 2),
+    TC_LAYOUT = (1 << 3),
+    TC_BORDER = (1 << 4),
+    TC_RECT = (1 << 5),
+    TC_WINDOW = (1 << 6),
+    TC_URGENT = (1 << 7),
+    TC_FOCUSED = (1 << 8),
+    TC_MARK = (1 << 9),
+    TC_FULLSCREEN = (1 << 10),
+    TC_FLOATING = (1 << 11),
+    TC_NODES = (1 << 12),
+    TC_FLOATING_NODES = (1 << 13)
+};
+
+/**
+ * Starts collecting changes. All existing containers count as reported,
+ * clients get them via GET_TREE. Called when the first client subscribes to
+ * the "tree" event.
+ *
+ */
+void tree_diff_start(void);
+
+/**
+ * Records that the given properties (TC_* bits) of the container changed, so
+ * that they are part of the next "tree" event. Containers which were not
+ * reported yet are sent as "added" with all properties instead.
+ *
+ * Has to be called by everything which changes a reported property of a
+ * container, except for the focus, which tree_diff_push() checks itself.
+ *
+ */
+void tree_diff_changed(Con *con, int fields);
+
+/**
+ * Sends the changes recorded with tree_diff_changed() since the previous call
+ * as one "tree" event. Called at the end of x_push_changes(). Stops
+ * collecting changes once no client is subscribed anymore.
+ *
+ */
+void tree_diff_push(void);
+
+/**
+ * Records the removal of the given container. Has to be called before the
+ * container is freed.
+ *
+ */
+void tree_diff_con_freed(Con *con);
@@ -13,6 +13,76 @@
 /** Stores the X11 window ID of the currently focused window */
 extern xcb_window_t focused_id;
 
+/** The kinds of X11 requests counted by x_request_stats. */
+typedef enum {
+    XR_CONFIGURE_WINDOW = 0,
+    XR_CHANGE_WINDOW_ATTRIBUTES = 1,
+    XR_COPY_AREA = 2,
+    XR_MAP_WINDOW = 3,
+    XR_UNMAP_WINDOW = 4,
+    XR_POLY_FILL_RECTANGLE = 5,
+    XR_NUM_TYPES = 6
+} x_request_t;
+
+/** Number of renders kept for the histogram of x_request_stats. */
+#define X_REQUEST_HISTORY 256
+
+/**
+ * Counts the X11 requests sent by x.c per call of tree_render(), exposed via
+ * the GET_X_STATS IPC request.
+ *
+ */
+struct x_request_stats {
+    /** Number of renders recorded so far. */
+    uint64_t renders;
+
+    /** Requests sent since the last call of x_request_stats_start(). */
+    uint32_t current[XR_NUM_TYPES];
+
+    /** Requests sent by the last render. */
+    uint32_t last[XR_NUM_TYPES];
+    /** Wall time of the last render, in seconds. */
+    double last_duration;
+    /** The container for which the last render sent the most requests (only
+     * used as an ID, it may have been freed since) and their number. */
+    Con *heaviest;
+    uint32_t heaviest_requests;
+
+    /** Requests sent since i3 was started, including those sent outside of
+     * tree_render() (e.g. when a window title changes). */
+    uint64_t total[XR_NUM_TYPES];
+
+    /** Ring buffer of the number of requests and the wall time of the last
+     * X_REQUEST_HISTORY renders. The newest entry is at
+     * (renders - 1) % X_REQUEST_HISTORY. */
+    struct {
+        uint32_t requests;
+        double duration;
+    } history[X_REQUEST_HISTORY];
+};
+
+extern struct x_request_stats x_request_stats;
+
+/**
+ * Returns the name of the given request type, as used in the GET_X_STATS
+ * reply.
+ *
+ */
+const char *x_request_name(x_request_t type);
+
+/**
+ * Starts recording the requests of a render. Called by tree_render().
+ *
+ */
+void x_request_stats_start(void);
+
+/**
+ * Finishes recording the requests of a render and logs them. Called by
+ * tree_render() after x_push_changes().
+ *
+ */
+void x_request_stats_finish(void);
+
 /**
  * Initializes the X11 part for the given container. Called exactly once for
  * every container from con_new().
@@ -47,6 +117,22 @@ void x_reinit(Con *con);
  */
 void x_con_kill(Con *con);
 
+/**
+ * Frees the pre-rendered title bars of all containers, so that they are
+ * rendered again. Called when reloading the config, since the font is not
+ * part of struct deco_strip_params.
+ *
+ */
+void x_invalidate_deco_strips(void);
+
+/**
+ * Returns true if the WM_PROTOCOLS reply for the given cookie contains the
+ * given protocol atom. Used when the request was sent earlier, see
+ * manage_window().
+ *
+ */
+bool window_protocols_contain(xcb_get_property_cookie_t cookie, xcb_atom_t atom);
+
 /**
  * Returns true if the client supports the given protocol atom (like WM_DELETE_WINDOW)
  *
@@ -24,6 +24,36 @@ extern xcb_screen_t *root_screen;
 
 static const i3Font *savedFont = NULL;
 
+/* Maximum number of text widths kept by the cache of predict_text_width().
+ * The hash table has twice as many buckets. */
+#define TEXT_WIDTH_CACHE_SIZE 512
+#define TEXT_WIDTH_CACHE_BUCKETS (2 * TEXT_WIDTH_CACHE_SIZE)
+
+/* A measured text width. The entries are chained per hash bucket and, at the
+ * same time, kept in a doubly linked list ordered by last use, so that the
+ * least recently used entry can be evicted when the cache is full. The cache
+ * only ever contains widths for savedFont, it is flushed when the font
+ * changes. */
+struct text_width_entry {
+    uint32_t hash;
+    bool is_markup;
+    size_t text_len;
+    char *text;
+    int width;
+
+    struct text_width_entry *bucket_next;
+    struct text_width_entry *lru_prev;
+    struct text_width_entry *lru_next;
+};
+
+static struct text_width_entry *text_width_buckets[TEXT_WIDTH_CACHE_BUCKETS];
+/* Most recently used entry and least recently used entry. */
+static struct text_width_entry *text_width_newest;
+static struct text_width_entry *text_width_oldest;
+static int text_width_entries;
+static uint64_t text_width_hits;
+static uint64_t text_width_misses;
+
 #if PANGO_SUPPORT
 static xcb_visualtype_t *root_visual_type;
 static double pango_font_red;
@@ -98,18 +128,13 @@ static bool load_pango_font(i3Font *font, const char *desc) {
 }
 
 /*
- * Draws text using Pango rendering.
+ * Draws text onto the given cairo context using the given layout, which may
+ * have been used for other text before.
  *
  */
-static void draw_text_pango(const char *text, size_t text_len,
-                            xcb_drawable_t drawable, int x, int y,
-                            int max_width, bool is_markup) {
-    /* Create the Pango layout */
-    /* root_visual_type is cached in load_pango_font */
-    cairo_surface_t *surface = cairo_xcb_surface_create(conn, drawable,
-                                                        root_visual_type, x + max_width, y + savedFont->height);
-    cairo_t *cr = cairo_create(surface);
-    PangoLayout *layout = create_layout_with_dpi(cr);
+static void draw_text_pango_layout(cairo_t *cr, PangoLayout *layout,
+                                   const char *text, size_t text_len,
+                                   int x, int y, int max_width, bool is_markup) {
     gint height;
 
     pango_layout_set_font_description(layout, savedFont->specific.pango_desc);
@@ -119,8 +144,11 @@ static void draw_text_pango(const char *text, size_t text_len,
 
     if (is_markup)
         pango_layout_set_markup(layout, text, text_len);
-    else
+    else {
+        /* Drop the attributes of a previous markup text */
+        pango_layout_set_attributes(layout, NULL);
         pango_layout_set_text(layout, text, text_len);
+    }
 
     /* Do the drawing */
     cairo_set_source_rgb(cr, pango_font_red, pango_font_green, pango_font_blue);
@@ -131,6 +159,23 @@ static void draw_text_pango(const char *text, size_t text_len,
     int yoffset = (height < savedFont->height ? 0.5 : 1) * (height - savedFont->height);
     cairo_move_to(cr, x, y - yoffset);
     pango_cairo_show_layout(cr, layout);
+}
+
+/*
+ * Draws text using Pango rendering.
+ *
+ */
+static void draw_text_pango(const char *text, size_t text_len,
+                            xcb_drawable_t drawable, int x, int y,
+                            int max_width, bool is_markup) {
+    /* Create the Pango layout */
+    /* root_visual_type is cached in load_pango_font */
+    cairo_surface_t *surface = cairo_xcb_surface_create(conn, drawable,
+                                                        root_visual_type, x + max_width, y + savedFont->height);
+    cairo_t *cr = cairo_create(surface);
+    PangoLayout *layout = create_layout_with_dpi(cr);
+
+    draw_text_pango_layout(cr, layout, text, text_len, x, y, max_width, is_markup);
 
     /* Free resources */
     g_object_unref(layout);
@@ -264,11 +309,30 @@ i3Font load_font(const char *pattern, const bool fallback) {
     return font;
 }
 
+/*
+ * Removes all entries from the text width cache.
+ *
+ */
+static void text_width_cache_flush(void) {
+    struct text_width_entry *entry = text_width_newest;
+    while (entry != NULL) {
+        struct text_width_entry *next = entry->lru_next;
+        free(entry->text);
+        free(entry);
+        entry = next;
+    }
+    memset(text_width_buckets, 0, sizeof(text_width_buckets));
+    text_width_newest = text_width_oldest = NULL;
+    text_width_entries = 0;
+}
+
 /*
  * Defines the font to be used for the forthcoming calls.
  *
  */
 void set_font(i3Font *font) {
+    if (font != savedFont)
+        text_width_cache_flush();
     savedFont = font;
 }
 
@@ -282,6 +346,8 @@ void free_font(void) {
     if (savedFont == NULL)
         return;
 
+    text_width_cache_flush();
+
     free(savedFont->pattern);
     switch (savedFont->type) {
         case FONT_TYPE_NONE:
@@ -454,6 +520,85 @@ void draw_text_ascii(const char *text, xcb_drawable_t drawable,
     }
 }
 
+struct text_renderer {
+    xcb_drawable_t drawable;
+    int width;
+    int height;
+
+#if PANGO_SUPPORT
+    /* Created when the first text is drawn with a Pango font. */
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    PangoLayout *layout;
+#endif
+};
+
+/*
+ * Creates a text renderer for the given drawable, which has to be of the
+ * given size and use the visual of the root window.
+ *
+ */
+text_renderer *text_renderer_new(xcb_drawable_t drawable, int width, int height) {
+    text_renderer *renderer = scalloc(sizeof(text_renderer));
+    renderer->drawable = drawable;
+    renderer->width = width;
+    renderer->height = height;
+    return renderer;
+}
+
+/*
+ * Frees the given text renderer (which may be NULL). Has to be called before
+ * its drawable is freed.
+ *
+ */
+void text_renderer_free(text_renderer *renderer) {
+    if (renderer == NULL)
+        return;
+
+#if PANGO_SUPPORT
+    if (renderer->layout != NULL) {
+        g_object_unref(renderer->layout);
+        cairo_destroy(renderer->cr);
+        cairo_surface_destroy(renderer->surface);
+    }
+#endif
+    free(renderer);
+}
+
+/*
+ * Draws text onto the drawable of the given renderer, just like draw_text().
+ *
+ */
+void text_renderer_draw(text_renderer *renderer, i3String *text,
+                        xcb_gcontext_t gc, int x, int y, int max_width) {
+    assert(savedFont != NULL);
+
+#if PANGO_SUPPORT
+    if (savedFont->type == FONT_TYPE_PANGO) {
+        if (renderer->layout == NULL) {
+            /* root_visual_type is cached in load_pango_font */
+            renderer->surface = cairo_xcb_surface_create(conn, renderer->drawable, root_visual_type,
+                                                         renderer->width, renderer->height);
+            renderer->cr = cairo_create(renderer->surface);
+            renderer->layout = create_layout_with_dpi(renderer->cr);
+        } else {
+            /* The drawable was changed with plain X11 requests since. */
+            cairo_surface_mark_dirty(renderer->surface);
+        }
+
+        draw_text_pango_layout(renderer->cr, renderer->layout,
+                               i3string_as_utf8(text), i3string_get_num_bytes(text),
+                               x, y, max_width, i3string_is_markup(text));
+        /* The caller draws onto the same drawable with plain X11 requests, so
+         * everything cairo buffered has to be sent now. */
+        cairo_surface_flush(renderer->surface);
+        return;
+    }
+#endif
+
+    draw_text(text, renderer->drawable, gc, x, y, max_width);
+}
+
 static int xcb_query_text_width(const xcb_char2b_t *text, size_t text_len) {
     /* Make the user know we’re using the slow path, but only once. */
     static bool first_invocation = true;
@@ -525,14 +670,93 @@ static int predict_text_width_xcb(const xcb_char2b_t *input, size_t text_len) {
     return width;
 }
 
+static void text_width_lru_unlink(struct text_width_entry *entry) {
+    if (entry->lru_prev != NULL)
+        entry->lru_prev->lru_next = entry->lru_next;
+    else
+        text_width_newest = entry->lru_next;
+    if (entry->lru_next != NULL)
+        entry->lru_next->lru_prev = entry->lru_prev;
+    else
+        text_width_oldest = entry->lru_prev;
+}
+
+static void text_width_lru_push(struct text_width_entry *entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = text_width_newest;
+    if (text_width_newest != NULL)
+        text_width_newest->lru_prev = entry;
+    text_width_newest = entry;
+    if (text_width_oldest == NULL)
+        text_width_oldest = entry;
+}
+
 /*
- * Predict the text width in pixels for the given text. Text must be
- * specified as an i3String.
+ * Removes the least recently used entry from the text width cache.
  *
  */
-int predict_text_width(i3String *text) {
-    assert(savedFont != NULL);
+static void text_width_cache_evict(void) {
+    struct text_width_entry *entry = text_width_oldest;
+    struct text_width_entry **walk = &text_width_buckets[entry->hash % TEXT_WIDTH_CACHE_BUCKETS];
+    while (*walk != entry)
+        walk = &((*walk)->bucket_next);
+    *walk = entry->bucket_next;
+
+    text_width_lru_unlink(entry);
+    free(entry->text);
+    free(entry);
+    text_width_entries--;
+}
+
+/*
+ * Returns the cached width of the given text or -1 if it is not cached yet.
+ *
+ */
+static int text_width_cache_get(uint32_t hash, const char *text, size_t text_len, bool is_markup) {
+    struct text_width_entry *entry;
+    for (entry = text_width_buckets[hash % TEXT_WIDTH_CACHE_BUCKETS]; entry != NULL; entry = entry->bucket_next) {
+        if (entry->hash != hash ||
+            entry->is_markup != is_markup ||
+            entry->text_len != text_len ||
+            memcmp(entry->text, text, text_len) != 0)
+            continue;
+
+        if (entry != text_width_newest) {
+            text_width_lru_unlink(entry);
+            text_width_lru_push(entry);
+        }
+        text_width_hits++;
+        return entry->width;
+    }
 
+    text_width_misses++;
+    return -1;
+}
+
+static void text_width_cache_put(uint32_t hash, const char *text, size_t text_len, bool is_markup, int width) {
+    if (text_width_entries == TEXT_WIDTH_CACHE_SIZE)
+        text_width_cache_evict();
+
+    struct text_width_entry *entry = smalloc(sizeof(struct text_width_entry));
+    entry->hash = hash;
+    entry->is_markup = is_markup;
+    entry->text_len = text_len;
+    entry->text = smalloc(text_len);
+    memcpy(entry->text, text, text_len);
+    entry->width = width;
+
+    struct text_width_entry **bucket = &text_width_buckets[hash % TEXT_WIDTH_CACHE_BUCKETS];
+    entry->bucket_next = *bucket;
+    *bucket = entry;
+    text_width_lru_push(entry);
+    text_width_entries++;
+}
+
+/*
+ * Measures the text width without looking at the cache.
+ *
+ */
+static int predict_text_width_uncached(i3String *text) {
     switch (savedFont->type) {
         case FONT_TYPE_NONE:
             /* Nothing to do */
@@ -550,3 +774,48 @@ int predict_text_width(i3String *text) {
             return 0;
     }
 }
+
+/*
+ * Predict the text width in pixels for the given text. Text must be
+ * specified as an i3String.
+ *
+ * The widths are cached (per font, text and markup flag), because measuring
+ * requires a Pango layout or even a round trip to the X server, while the
+ * same window titles and i3bar blocks are measured over and over again.
+ *
+ */
+int predict_text_width(i3String *text) {
+    assert(savedFont != NULL);
+
+    if (savedFont->type == FONT_TYPE_NONE)
+        return 0;
+
+    const char *utf8 = i3string_as_utf8(text);
+    const size_t len = i3string_get_num_bytes(text);
+    const bool is_markup = i3string_is_markup(text);
+
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)utf8[i];
+        hash *= 16777619u;
+    }
+    hash ^= is_markup;
+
+    int width = text_width_cache_get(hash, utf8, len, is_markup);
+    if (width < 0) {
+        width = predict_text_width_uncached(text);
+        text_width_cache_put(hash, utf8, len, is_markup, width);
+    }
+    return width;
+}
+
+/*
+ * Returns the number of hits and misses of the text width cache used by
+ * predict_text_width().
+ *
+ */
+void text_width_cache_stats(uint64_t *hits, uint64_t *misses) {
+    *hits = text_width_hits;
+    *misses = text_width_misses;
+}
@@ -47,6 +47,7 @@ state INITIAL:
   'show_marks'                             -> SHOW_MARKS
   'workspace'                              -> WORKSPACE
   'ipc_socket', 'ipc-socket'               -> IPC_SOCKET
+  'ipc_buffer_limit'                       -> IPC_BUFFER_LIMIT
   'restart_state'                          -> RESTART_STATE
   'popup_during_fullscreen'                -> POPUP_DURING_FULLSCREEN
   exectype = 'exec_always', 'exec'         -> EXEC
@@ -290,6 +291,17 @@ state IPC_SOCKET:
   path = string
       -> call cfg_ipc_socket($path)
 
+# ipc_buffer_limit <size> kb
+state IPC_BUFFER_LIMIT:
+  size_kb = number
+      -> IPC_BUFFER_LIMIT_KB
+
+state IPC_BUFFER_LIMIT_KB:
+  'kb'
+      ->
+  end
+      -> call cfg_ipc_buffer_limit(&size_kb)
+
 # restart_state <path> (for testcases)
 state RESTART_STATE:
   path = string
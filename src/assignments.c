@@ -60,9 +60,10 @@ void run_assignments(i3Window *window) {
         window->ran_assignments[window->nr_assignments - 1] = current;
     }
 
-    /* If any of the commands required re-rendering, we will do that now. */
+    /* If any of the commands required re-rendering, request it. The render
+     * happens once all events of the current batch have been handled. */
     if (needs_tree_render)
-        tree_render();
+        tree_request_render();
 }
 
 /*
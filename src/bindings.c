@@ -128,67 +128,266 @@ void grab_all_keys(xcb_connection_t *conn, bool bind_mode_switch) {
     }
 }
 
+/* Number of slots the binding table starts out with. Has to be a power of
+ * two. */
+#define BINDING_TABLE_INITIAL_SIZE 64
+
+/* Bits of the modifier mask which can be bound to (see
+ * get_binding_from_xcb_event()). */
+#define BINDING_MODS_MASK (0xFF | BIND_MODE_SWITCH)
+
+/* A binding together with its position in the list of bindings, so that
+ * candidates from different sources can be ordered the same way as the list. */
+struct binding_ref {
+    Binding *bind;
+    uint32_t position;
+};
+
+/* All bindings of the current mode which can be triggered by one combination
+ * of input type, keycode (or button) and modifiers, in list order. */
+struct binding_slot {
+    uint32_t key;
+    uint32_t first;
+    uint32_t num;
+};
+
+/*
+ * A lookup table for the bindings of the current mode, rebuilt by
+ * translate_keysyms() (which is also called when switching modes). The slots
+ * form an open-addressing hash table (using linear probing) which refers to
+ * runs of the refs array. Slots with num == 0 are empty.
+ *
+ */
+static struct {
+    struct binding_slot *slots;
+    uint32_t size;
+    struct binding_ref *refs;
+    uint32_t num_refs;
+} binding_table;
+
+/* Bindings of the current mode which were marked as
+ * B_UPON_KEYRELEASE_IGNORE_MODS by a KeyPress: on KeyRelease, they match
+ * regardless of the modifiers, so they have to be checked separately. */
+static struct binding_ref *pending_releases = NULL;
+static uint32_t num_pending_releases = 0;
+static uint32_t size_pending_releases = 0;
+
+static uint32_t binding_key(input_type_t input_type, uint32_t input_code, uint32_t mods) {
+    return ((uint32_t)input_type << 25) | ((input_code & 0xFFFF) << 9) | (mods & BINDING_MODS_MASK);
+}
+
+static uint32_t binding_key_home(uint32_t key) {
+    /* Fibonacci hashing, the upper bits are taken by masking after the
+     * shift below. */
+    return (key * 2654435769u) >> 16;
+}
+
+static struct binding_slot *binding_table_find(uint32_t key) {
+    if (binding_table.size == 0)
+        return NULL;
+
+    const uint32_t mask = binding_table.size - 1;
+    for (uint32_t i = binding_key_home(key) & mask;; i = (i + 1) & mask) {
+        struct binding_slot *slot = &(binding_table.slots[i]);
+        if (slot->num == 0)
+            return NULL;
+        if (slot->key == key)
+            return slot;
+    }
+}
+
+/* Used by build_binding_table() to sort the references by key and position. */
+struct binding_entry {
+    uint32_t key;
+    struct binding_ref ref;
+};
+
+static int binding_entry_cmp(const void *a, const void *b) {
+    const struct binding_entry *first = a, *second = b;
+    if (first->key != second->key)
+        return (first->key < second->key ? -1 : 1);
+    if (first->ref.position != second->ref.position)
+        return (first->ref.position < second->ref.position ? -1 : 1);
+    return 0;
+}
+
+/*
+ * Returns true if the given binding is triggered by the given keycode (or
+ * button), ignoring the modifiers.
+ *
+ */
+static bool binding_matches_code(Binding *bind, uint16_t input_code) {
+    /* For keyboard bindings where a symbol was specified by the user, we
+     * need to look in the array of translated keycodes for the event’s
+     * keycode */
+    if (bind->input_type == B_KEYBOARD && bind->symbol != NULL) {
+        xcb_keycode_t input_keycode = (xcb_keycode_t)input_code;
+        return (memmem(bind->translated_to,
+                       bind->number_keycodes * sizeof(xcb_keycode_t),
+                       &input_keycode, sizeof(xcb_keycode_t)) != NULL);
+    }
+
+    /* This case is easier: The user specified a keycode */
+    return (bind->keycode == input_code);
+}
+
+/*
+ * Rebuilds the binding table and the pending releases from the bindings of
+ * the current mode. Called after the keycodes of the bindings changed.
+ *
+ */
+static void build_binding_table(void) {
+    struct binding_entry *entries = NULL;
+    uint32_t num_entries = 0;
+    Binding *bind;
+    uint32_t position = 0;
+
+    num_pending_releases = 0;
+
+#define ADD_ENTRY(code)                                                                            \
+    do {                                                                                           \
+        entries = srealloc(entries, (num_entries + 1) * sizeof(struct binding_entry));             \
+        entries[num_entries].key = binding_key(bind->input_type, (code), bind->mods);              \
+        entries[num_entries].ref = (struct binding_ref){.bind = bind, .position = position};     \
+        num_entries++;                                                                             \
+    } while (0)
+
+    TAILQ_FOREACH(bind, bindings, bindings) {
+        position++;
+
+        if (bind->release == B_UPON_KEYRELEASE_IGNORE_MODS) {
+            if (num_pending_releases == size_pending_releases) {
+                size_pending_releases = (size_pending_releases == 0 ? 8 : size_pending_releases * 2);
+                pending_releases = srealloc(pending_releases, size_pending_releases * sizeof(struct binding_ref));
+            }
+            pending_releases[num_pending_releases++] = (struct binding_ref){.bind = bind, .position = position};
+        }
+
+        /* Modifiers which can never be part of an event cannot match. */
+        if ((bind->mods & ~BINDING_MODS_MASK) != 0)
+            continue;
+
+        if (bind->input_type == B_KEYBOARD && bind->symbol != NULL) {
+            for (uint32_t i = 0; i < bind->number_keycodes; i++)
+                ADD_ENTRY(bind->translated_to[i]);
+        } else
+            ADD_ENTRY(bind->keycode);
+    }
+
+#undef ADD_ENTRY
+
+    if (num_entries > 0)
+        qsort(entries, num_entries, sizeof(struct binding_entry), binding_entry_cmp);
+
+    FREE(binding_table.slots);
+    FREE(binding_table.refs);
+    binding_table.size = BINDING_TABLE_INITIAL_SIZE;
+    /* Keep the table at most half full. */
+    while (binding_table.size < num_entries * 2)
+        binding_table.size *= 2;
+    binding_table.slots = scalloc(binding_table.size * sizeof(struct binding_slot));
+    binding_table.refs = smalloc((num_entries > 0 ? num_entries : 1) * sizeof(struct binding_ref));
+    binding_table.num_refs = num_entries;
+
+    const uint32_t mask = binding_table.size - 1;
+    struct binding_slot *slot = NULL;
+    for (uint32_t i = 0; i < num_entries; i++) {
+        if (slot == NULL || slot->key != entries[i].key) {
+            uint32_t j = binding_key_home(entries[i].key) & mask;
+            while (binding_table.slots[j].num != 0)
+                j = (j + 1) & mask;
+            slot = &(binding_table.slots[j]);
+            slot->key = entries[i].key;
+            slot->first = i;
+            slot->num = 0;
+        }
+        binding_table.refs[slot->first + slot->num] = entries[i].ref;
+        slot->num++;
+    }
+
+    free(entries);
+    DLOG("Built binding table with %d slots for %d keycode/modifier combinations\n",
+         binding_table.size, num_entries);
+}
+
 /*
  * Returns a pointer to the Binding with the specified modifiers and
  * keycode or NULL if no such binding exists.
  *
+ * The result is the first binding in the list of bindings of the current mode
+ * which matches, but the bindings are looked up in the binding table instead
+ * of walking the whole list.
+ *
  */
 static Binding *get_binding(uint16_t modifiers, bool is_release, uint16_t input_code, input_type_t input_type) {
-    Binding *bind;
+    struct binding_slot *slot = binding_table_find(binding_key(input_type, input_code, modifiers));
+    uint32_t i;
 
     if (!is_release) {
         /* On a press event, we first reset all B_UPON_KEYRELEASE_IGNORE_MODS
          * bindings back to B_UPON_KEYRELEASE */
-        TAILQ_FOREACH(bind, bindings, bindings) {
-            if (bind->input_type != input_type)
+        for (i = 0; i < num_pending_releases;) {
+            if (pending_releases[i].bind->input_type != input_type) {
+                i++;
                 continue;
-            if (bind->release == B_UPON_KEYRELEASE_IGNORE_MODS)
-                bind->release = B_UPON_KEYRELEASE;
+            }
+            pending_releases[i].bind->release = B_UPON_KEYRELEASE;
+            pending_releases[i] = pending_releases[--num_pending_releases];
         }
-    }
 
-    TAILQ_FOREACH(bind, bindings, bindings) {
-        /* First compare the modifiers (unless this is a
-         * B_UPON_KEYRELEASE_IGNORE_MODS binding and this is a KeyRelease
-         * event) */
-        if (bind->input_type != input_type)
-            continue;
-        if (bind->mods != modifiers &&
-            (bind->release != B_UPON_KEYRELEASE_IGNORE_MODS ||
-             !is_release))
-            continue;
+        if (slot == NULL)
+            return NULL;
 
-        /* For keyboard bindings where a symbol was specified by the user, we
-         * need to look in the array of translated keycodes for the event’s
-         * keycode */
-        if (input_type == B_KEYBOARD && bind->symbol != NULL) {
-            xcb_keycode_t input_keycode = (xcb_keycode_t)input_code;
-            if (memmem(bind->translated_to,
-                       bind->number_keycodes * sizeof(xcb_keycode_t),
-                       &input_keycode, sizeof(xcb_keycode_t)) == NULL)
-                continue;
-        } else {
-            /* This case is easier: The user specified a keycode */
-            if (bind->keycode != input_code)
+        for (i = 0; i < slot->num; i++) {
+            struct binding_ref *ref = &(binding_table.refs[slot->first + i]);
+            Binding *bind = ref->bind;
+
+            /* If this binding is a release binding, it matches the key which
+             * the user pressed. We therefore mark it as
+             * B_UPON_KEYRELEASE_IGNORE_MODS for later, so that the user can
+             * release the modifiers before the actual key or button and the
+             * release event will still be matched. */
+            if (bind->release == B_UPON_KEYRELEASE) {
+                bind->release = B_UPON_KEYRELEASE_IGNORE_MODS;
+                if (num_pending_releases == size_pending_releases) {
+                    size_pending_releases = (size_pending_releases == 0 ? 8 : size_pending_releases * 2);
+                    pending_releases = srealloc(pending_releases, size_pending_releases * sizeof(struct binding_ref));
+                }
+                pending_releases[num_pending_releases++] = *ref;
                 continue;
+            }
+
+            if (bind->release == B_UPON_KEYPRESS)
+                return bind;
         }
 
-        /* If this binding is a release binding, it matches the key which the
-         * user pressed. We therefore mark it as B_UPON_KEYRELEASE_IGNORE_MODS
-         * for later, so that the user can release the modifiers before the
-         * actual key or button and the release event will still be matched. */
-        if (bind->release == B_UPON_KEYRELEASE && !is_release)
-            bind->release = B_UPON_KEYRELEASE_IGNORE_MODS;
+        return NULL;
+    }
 
-        /* Check if the binding is for a press or a release event */
-        if ((bind->release == B_UPON_KEYPRESS && is_release) ||
-            (bind->release >= B_UPON_KEYRELEASE && !is_release))
-            continue;
+    /* On a release event, the result is the first release binding which
+     * either has the exact modifiers or was marked as
+     * B_UPON_KEYRELEASE_IGNORE_MODS by the KeyPress. */
+    struct binding_ref *best = NULL;
+    if (slot != NULL) {
+        for (i = 0; i < slot->num; i++) {
+            struct binding_ref *ref = &(binding_table.refs[slot->first + i]);
+            if (ref->bind->release != B_UPON_KEYPRESS) {
+                best = ref;
+                break;
+            }
+        }
+    }
 
-        break;
+    for (i = 0; i < num_pending_releases; i++) {
+        struct binding_ref *ref = &(pending_releases[i]);
+        if (ref->bind->input_type != input_type ||
+            (best != NULL && best->position < ref->position) ||
+            !binding_matches_code(ref->bind, input_code))
+            continue;
+        best = ref;
     }
 
-    return (bind == TAILQ_END(bindings) ? NULL : bind);
+    return (best == NULL ? NULL : best->bind);
 }
 
 /*
@@ -301,6 +500,8 @@ void translate_keysyms(void) {
         DLOG("Translated symbol \"%s\" to %d keycode (mods %d)\n", bind->symbol,
              bind->number_keycodes, bind->mods);
     }
+
+    build_binding_table();
 }
 
 /*
@@ -400,6 +601,7 @@ static Binding *binding_copy(Binding *bind) {
         ret->translated_to = smalloc(sizeof(xcb_keycode_t) * bind->number_keycodes);
         memcpy(ret->translated_to, bind->translated_to, sizeof(xcb_keycode_t) * bind->number_keycodes);
     }
+    ret->program = command_program_ref(bind->program);
     return ret;
 }
 
@@ -414,33 +616,49 @@ void binding_free(Binding *bind) {
     FREE(bind->symbol);
     FREE(bind->translated_to);
     FREE(bind->command);
+    command_program_free(bind->program);
     FREE(bind);
 }
 
 /*
  * Runs the given binding and handles parse errors. If con is passed, it will
  * execute the command binding with that container selected by criteria.
- * Returns a CommandResult for running the binding's command. Caller should
- * render tree if needs_tree_render is true. Free with command_result_free().
+ * Returns a CommandResult for running the binding's command. If the command
+ * needs the tree to be rendered, a render is requested (see
+ * tree_request_render()). Free with command_result_free().
  *
  */
 CommandResult *run_binding(Binding *bind, Con *con) {
-    char *command;
-
-    /* We need to copy the binding and command since “reload” may be part of
-     * the command, and then the memory that bind points to may not contain the
-     * same data anymore. */
-    if (con == NULL)
-        command = sstrdup(bind->command);
-    else
-        sasprintf(&command, "[con_id=\"%p\"] %s", con, bind->command);
+    CommandResult *result;
+
+    /* The command is only parsed the first time the binding is run. This
+     * cannot happen when loading the config, since that happens while the
+     * “reload” command is being executed. */
+    if (bind->program == NULL && !bind->program_failed) {
+        bind->program = command_program_new(bind->command);
+        bind->program_failed = (bind->program == NULL);
+    }
 
+    /* We need to copy the binding (which keeps the program alive) since
+     * “reload” may be part of the command, and then the memory that bind
+     * points to may not contain the same data anymore. */
     Binding *bind_cp = binding_copy(bind);
-    CommandResult *result = parse_command(command, NULL);
-    free(command);
+    if (bind_cp->program != NULL) {
+        result = command_program_run(bind_cp->program, con);
+    } else {
+        /* Parse the command again to report the error. */
+        char *command;
+        if (con == NULL)
+            command = sstrdup(bind->command);
+        else
+            sasprintf(&command, "[con_id=\"%p\"] %s", con, bind->command);
+
+        result = parse_command(command, NULL);
+        free(command);
+    }
 
     if (result->needs_tree_render)
-        tree_render();
+        tree_request_render();
 
     if (result->parse_error) {
         char *pageraction;
@@ -198,9 +198,6 @@ static int route_click(Con *con, xcb_button_press_event_t *event, const bool mod
             xcb_allow_events(conn, XCB_ALLOW_ASYNC_POINTER, event->time);
             xcb_flush(conn);
 
-            if (result->needs_tree_render)
-                tree_render();
-
             command_result_free(result);
 
             return 0;
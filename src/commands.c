@@ -50,8 +50,7 @@
 #define HANDLE_EMPTY_MATCH                              \
     do {                                                \
         if (match_is_empty(current_match)) {            \
-            owindow *ow = smalloc(sizeof(owindow));     \
-            ow->con = focused;                          \
+            owindow *ow = owindow_new(focused);         \
             TAILQ_INIT(&owindows);                      \
             TAILQ_INSERT_TAIL(&owindows, ow, owindows); \
         }                                               \
@@ -235,74 +234,132 @@ typedef TAILQ_HEAD(owindows_head, owindow) owindows_head;
 
 static owindows_head owindows;
 
+/* owindows are not freed one by one. Instead, they are taken from a list of
+ * blocks which is reused for every command, see owindow_new(). */
+#define OWINDOW_BLOCK_SIZE 64
+
+typedef struct owindow_block {
+    owindow owindows[OWINDOW_BLOCK_SIZE];
+    struct owindow_block *next;
+} owindow_block;
+
+static owindow_block *owindow_blocks;
+/* The block owindow_new() currently allocates from and how many of its
+ * owindows are in use. */
+static owindow_block *owindow_current;
+static int owindow_used;
+
+/*
+ * Returns a new owindow for the given container. It stays valid until the
+ * next cmd_criteria_init().
+ *
+ */
+static owindow *owindow_new(Con *con) {
+    if (owindow_current == NULL || owindow_used == OWINDOW_BLOCK_SIZE) {
+        owindow_block **next = (owindow_current == NULL ? &owindow_blocks : &(owindow_current->next));
+        if (*next == NULL) {
+            *next = smalloc(sizeof(owindow_block));
+            (*next)->next = NULL;
+        }
+        owindow_current = *next;
+        owindow_used = 0;
+    }
+
+    owindow *ow = &(owindow_current->owindows[owindow_used++]);
+    ow->con = con;
+    return ow;
+}
+
 /*
  * Initializes the specified 'Match' data structure and the initial state of
  * commands.c for matching target windows of a command.
  *
  */
 void cmd_criteria_init(I3_CMD) {
-    Con *con;
-    owindow *ow;
-
     DLOG("Initializing criteria, current_match = %p\n", current_match);
     match_free(current_match);
     match_init(current_match);
-    while (!TAILQ_EMPTY(&owindows)) {
-        ow = TAILQ_FIRST(&owindows);
-        TAILQ_REMOVE(&owindows, ow, owindows);
-        free(ow);
-    }
+
+    /* All owindows of the previous command are unused now. The list of
+     * candidates is only built once a match specification is finished, see
+     * cmd_criteria_match_windows(). */
+    owindow_current = NULL;
+    owindow_used = 0;
     TAILQ_INIT(&owindows);
-    /* copy all_cons */
-    TAILQ_FOREACH(con, &all_cons, all_cons) {
-        ow = smalloc(sizeof(owindow));
-        ow->con = con;
-        TAILQ_INSERT_TAIL(&owindows, ow, owindows);
+}
+
+/*
+ * Adds the given container to owindows if its window matches the current
+ * match specification.
+ *
+ */
+static void add_if_window_matches(Match *current_match, Con *con) {
+    DLOG("checking if con %p / %s matches\n", con, con->name);
+    if (con->window && match_matches_window(current_match, con->window)) {
+        DLOG("matches window!\n");
+        TAILQ_INSERT_TAIL(&owindows, owindow_new(con), owindows);
+    } else {
+        DLOG("doesnt match\n");
     }
 }
 
 /*
  * A match specification just finished (the closing square bracket was found),
- * so we filter the list of owindows.
+ * so we fill the list of owindows with the matching containers.
  *
  */
 void cmd_criteria_match_windows(I3_CMD) {
-    owindow *next, *current;
+    owindow *current;
+    Con *con;
 
     DLOG("match specification finished, matching...\n");
-    /* copy the old list head to iterate through it and start with a fresh
-     * list which will contain only matching windows */
-    struct owindows_head old = owindows;
     TAILQ_INIT(&owindows);
-    for (next = TAILQ_FIRST(&old); next != TAILQ_END(&old);) {
-        /* make a copy of the next pointer and advance the pointer to the
-         * next element as we are going to invalidate the element’s
-         * next/prev pointers by calling TAILQ_INSERT_TAIL later */
-        current = next;
-        next = TAILQ_NEXT(next, owindows);
-
-        DLOG("checking if con %p / %s matches\n", current->con, current->con->name);
-        if (current_match->con_id != NULL) {
-            if (current_match->con_id == current->con) {
+
+    if (current_match->con_id != NULL) {
+        /* Only the con_id is checked, but it has to be a container which
+         * still exists. */
+        TAILQ_FOREACH(con, &all_cons, all_cons) {
+            if (con == current_match->con_id) {
                 DLOG("matches container!\n");
-                TAILQ_INSERT_TAIL(&owindows, current, owindows);
-            } else {
-                DLOG("doesnt match\n");
-                free(current);
+                TAILQ_INSERT_TAIL(&owindows, owindow_new(con), owindows);
+                break;
+            }
+        }
+    } else if (current_match->mark != NULL) {
+        /* Only containers which carry a mark can match a mark criterion, so
+         * we only need to look at those instead of at every container. A
+         * mark given literally can even be looked up in the mark index. Note
+         * that like PCRE, the literal also matches a mark with a trailing
+         * newline. */
+        struct regex *mark = current_match->mark;
+        if (mark->literal_type == RE_LITERAL_EXACT) {
+            char *with_newline;
+            sasprintf(&with_newline, "%s\n", mark->literal);
+            const char *names[] = {mark->literal, with_newline};
+            for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+                if ((con = con_index_get_by_mark(names[i])) == NULL)
+                    continue;
+                DLOG("match by mark: %p / %s\n", con, con->name);
+                TAILQ_INSERT_TAIL(&owindows, owindow_new(con), owindows);
             }
-        } else if (current_match->mark != NULL && current->con->mark != NULL &&
-                   regex_matches(current_match->mark, current->con->mark)) {
-            DLOG("match by mark\n");
-            TAILQ_INSERT_TAIL(&owindows, current, owindows);
+            free(with_newline);
         } else {
-            if (current->con->window && match_matches_window(current_match, current->con->window)) {
-                DLOG("matches window!\n");
-                TAILQ_INSERT_TAIL(&owindows, current, owindows);
-            } else {
-                DLOG("doesnt match\n");
-                free(current);
+            TAILQ_FOREACH(con, &marked_cons, marked_cons) {
+                if (!regex_matches(mark, con->mark))
+                    continue;
+
+                DLOG("match by mark: %p / %s\n", con, con->name);
+                TAILQ_INSERT_TAIL(&owindows, owindow_new(con), owindows);
             }
         }
+    } else if (current_match->id != XCB_NONE) {
+        /* At most the container of the given window can match. */
+        if ((con = con_by_window_id(current_match->id)) != NULL)
+            add_if_window_matches(current_match, con);
+    } else {
+        TAILQ_FOREACH(con, &all_cons, all_cons) {
+            add_if_window_matches(current_match, con);
+        }
     }
 
     TAILQ_FOREACH(current, &owindows, owindows) {
@@ -1089,24 +1146,11 @@ void cmd_mark(I3_CMD, char *mark, char *toggle) {
     current->con->mark_changed = true;
     if (toggle != NULL && current->con->mark && strcmp(current->con->mark, mark) == 0) {
         DLOG("removing window mark %s\n", mark);
-        FREE(current->con->mark);
+        con_unmark(current->con);
     } else {
+        /* con_mark() also clears the mark from any other window. */
         DLOG("marking window with str %s\n", mark);
-        FREE(current->con->mark);
-        current->con->mark = sstrdup(mark);
-    }
-
-    DLOG("Clearing all non-matched windows with this mark\n");
-    Con *con;
-    TAILQ_FOREACH(con, &all_cons, all_cons) {
-        /* Skip matched window, we took care of it already. */
-        if (current->con == con)
-            continue;
-
-        if (con->mark && strcmp(con->mark, mark) == 0) {
-            FREE(con->mark);
-            con->mark_changed = true;
-        }
+        con_mark(current->con, mark);
     }
 
     cmd_output->needs_tree_render = true;
@@ -1120,21 +1164,13 @@ void cmd_mark(I3_CMD, char *mark, char *toggle) {
  */
 void cmd_unmark(I3_CMD, char *mark) {
     if (mark == NULL) {
-        Con *con;
-        TAILQ_FOREACH(con, &all_cons, all_cons) {
-            if (con->mark == NULL)
-                continue;
-
-            FREE(con->mark);
-            con->mark_changed = true;
-        }
+        while (!TAILQ_EMPTY(&marked_cons))
+            con_unmark(TAILQ_FIRST(&marked_cons));
         DLOG("Removed all window marks.\n");
     } else {
         Con *con = con_by_mark(mark);
-        if (con != NULL) {
-            FREE(con->mark);
-            con->mark_changed = true;
-        }
+        if (con != NULL)
+            con_unmark(con);
         DLOG("Removed window mark \"%s\".\n", mark);
     }
 
@@ -1977,6 +2013,7 @@ void cmd_rename_workspace(I3_CMD, char *old_name, char *new_name) {
     /* Change the name and try to parse it as a number. */
     FREE(workspace->name);
     workspace->name = sstrdup(new_name);
+    tree_diff_changed(workspace, TC_NAME);
 
     workspace->num = ws_name_to_number(new_name);
     LOG("num = %d\n", workspace->num);
@@ -2222,8 +2259,10 @@ void cmd_gaps(I3_CMD, char *type, char *scope, char *mode, char *value) {
         }                                                          \
                                                                    \
         config.gaps.type = current_value;                          \
+        con_invalidate(croot);                                     \
     } else {                                                       \
         workspace->gaps.type = current_value - config.gaps.type;   \
+        con_invalidate(workspace);                                 \
     }
 
     if (!strcmp(type, "inner")) {
@@ -56,6 +56,11 @@ typedef struct token {
     union {
         uint16_t call_identifier;
     } extra;
+    /* How to match this token, so that the name does not have to be
+     * compared. */
+    cmdp_token_kind kind;
+    /* The length of a literal, without the leading single quote. */
+    int length;
 } cmdp_token;
 
 typedef struct tokenptr {
@@ -184,7 +189,61 @@ static struct CommandResultIR command_output;
 
 #include "GENERATED_command_call.h"
 
-static void next_state(const cmdp_token *token) {
+/*******************************************************************************
+ * Pre-parsed commands, see command_program_new().
+ ******************************************************************************/
+
+/* Resets the criteria, like a ';' does. Used instead of a call_identifier. */
+#define OP_CRITERIA_INIT -1
+
+/* One call of a command function, with the identified literals and strings
+ * which parse_command() would have pushed on the stack. */
+struct command_op {
+    int call_identifier;
+    int n_args;
+    struct stack_entry args[10];
+};
+
+struct CommandProgram {
+    /* The command text, for logging. */
+    char *input;
+    int n_ops;
+    struct command_op *ops;
+    /* Number of references, see command_program_ref(). */
+    int refcount;
+};
+
+/*
+ * Appends a call to the program, moving the current contents of the stack
+ * into it.
+ *
+ */
+static void command_program_add_op(CommandProgram *program, int call_identifier) {
+    program->ops = srealloc(program->ops, sizeof(struct command_op) * (program->n_ops + 1));
+    struct command_op *op = &(program->ops[program->n_ops++]);
+    op->call_identifier = call_identifier;
+    op->n_args = 0;
+    for (int c = 0; c < 10; c++) {
+        if (stack[c].identifier == NULL)
+            break;
+        op->args[op->n_args++] = stack[c];
+        stack[c].identifier = NULL;
+        stack[c].str = NULL;
+    }
+}
+
+/*
+ * Transitions to the next state. If program is not NULL, calls are recorded
+ * into it instead of being made.
+ *
+ */
+static void next_state(const cmdp_token *token, CommandProgram *program) {
+    if (token->next_state == __CALL && program != NULL) {
+        command_program_add_op(program, token->extra.call_identifier);
+        state = GENERATED_call_next_state[token->extra.call_identifier];
+        return;
+    }
+
     if (token->next_state == __CALL) {
         subcommand_output.json_gen = command_output.json_gen;
         subcommand_output.needs_tree_render = false;
@@ -261,34 +320,20 @@ char *parse_string(const char **walk, bool as_word) {
 }
 
 /*
- * Parses and executes the given command. If a caller-allocated yajl_gen is
- * passed, a json reply will be generated in the format specified by the ipc
- * protocol. Pass NULL if no json reply is required.
+ * Walks over the given command, transitioning through the states with
+ * next_state() (so the commands are executed, or recorded into program if it
+ * is not NULL). Returns NULL on success or the position of the first token
+ * which could not be parsed. In that case, state is the state in which
+ * parsing failed.
  *
- * Free the returned CommandResult with command_result_free().
  */
-CommandResult *parse_command(const char *input, yajl_gen gen) {
-    DLOG("COMMAND: *%s*\n", input);
-    state = INITIAL;
-    CommandResult *result = scalloc(sizeof(CommandResult));
-
-    /* A YAJL JSON generator used for formatting replies. */
-    command_output.json_gen = gen;
-
-    y(array_open);
-    command_output.needs_tree_render = false;
-
+static const char *walk_command(const char *input, CommandProgram *program) {
     const char *walk = input;
     const size_t len = strlen(input);
     int c;
     const cmdp_token *token;
     bool token_handled;
 
-// TODO: make this testable
-#ifndef TEST_PARSER
-    cmd_criteria_init(&current_match, &subcommand_output);
-#endif
-
     /* The "<=" operator is intentional: We also handle the terminating 0-byte
      * explicitly by looking for an 'end' token. */
     while ((size_t)(walk - input) <= len) {
@@ -299,26 +344,30 @@ CommandResult *parse_command(const char *input, yajl_gen gen) {
             walk++;
 
         cmdp_token_ptr *ptr = &(tokens[state]);
+        /* Only the tokens which can match the first character need to be
+         * tried, see generate-command-parser.pl. */
+        int n;
+        const uint8_t *candidates = GENERATED_candidates(state, *walk, &n);
         token_handled = false;
-        for (c = 0; c < ptr->n; c++) {
-            token = &(ptr->array[c]);
+        for (c = 0; c < n; c++) {
+            token = &(ptr->array[candidates[c]]);
 
             /* A literal. */
-            if (token->name[0] == '\'') {
-                if (strncasecmp(walk, token->name + 1, strlen(token->name) - 1) == 0) {
+            if (token->kind == TOKEN_LITERAL) {
+                if (strncasecmp(walk, token->name + 1, token->length) == 0) {
                     if (token->identifier != NULL)
                         push_string(token->identifier, sstrdup(token->name + 1));
-                    walk += strlen(token->name) - 1;
-                    next_state(token);
+                    walk += token->length;
+                    next_state(token, program);
                     token_handled = true;
                     break;
                 }
                 continue;
             }
 
-            if (strcmp(token->name, "string") == 0 ||
-                strcmp(token->name, "word") == 0) {
-                char *str = parse_string(&walk, (token->name[0] != 's'));
+            if (token->kind == TOKEN_STRING ||
+                token->kind == TOKEN_WORD) {
+                char *str = parse_string(&walk, (token->kind == TOKEN_WORD));
                 if (str != NULL) {
                     if (token->identifier)
                         push_string(token->identifier, str);
@@ -326,15 +375,15 @@ CommandResult *parse_command(const char *input, yajl_gen gen) {
                      * double quote. */
                     if (*walk == '"')
                         walk++;
-                    next_state(token);
+                    next_state(token, program);
                     token_handled = true;
                     break;
                 }
             }
 
-            if (strcmp(token->name, "end") == 0) {
+            if (token->kind == TOKEN_END) {
                 if (*walk == '\0' || *walk == ',' || *walk == ';') {
-                    next_state(token);
+                    next_state(token, program);
                     token_handled = true;
 /* To make sure we start with an appropriate matching
                      * datastructure for commands which do *not* specify any
@@ -342,8 +391,12 @@ CommandResult *parse_command(const char *input, yajl_gen gen) {
                      * every command. */
 // TODO: make this testable
 #ifndef TEST_PARSER
-                    if (*walk == '\0' || *walk == ';')
-                        cmd_criteria_init(&current_match, &subcommand_output);
+                    if (*walk == '\0' || *walk == ';') {
+                        if (program != NULL)
+                            command_program_add_op(program, OP_CRITERIA_INIT);
+                        else
+                            cmd_criteria_init(&current_match, &subcommand_output);
+                    }
 #endif
                     walk++;
                     break;
@@ -352,88 +405,223 @@ CommandResult *parse_command(const char *input, yajl_gen gen) {
         }
 
         if (!token_handled) {
-            /* Figure out how much memory we will need to fill in the names of
-             * all tokens afterwards. */
-            int tokenlen = 0;
-            for (c = 0; c < ptr->n; c++)
-                tokenlen += strlen(ptr->array[c].name) + strlen("'', ");
-
-            /* Build up a decent error message. We include the problem, the
-             * full input, and underline the position where the parser
-             * currently is. */
-            char *errormessage;
-            char *possible_tokens = smalloc(tokenlen + 1);
-            char *tokenwalk = possible_tokens;
-            for (c = 0; c < ptr->n; c++) {
-                token = &(ptr->array[c]);
-                if (token->name[0] == '\'') {
-                    /* A literal is copied to the error message enclosed with
-                     * single quotes. */
-                    *tokenwalk++ = '\'';
-                    strcpy(tokenwalk, token->name + 1);
-                    tokenwalk += strlen(token->name + 1);
-                    *tokenwalk++ = '\'';
-                } else {
-                    /* Any other token is copied to the error message enclosed
-                     * with angle brackets. */
-                    *tokenwalk++ = '<';
-                    strcpy(tokenwalk, token->name);
-                    tokenwalk += strlen(token->name);
-                    *tokenwalk++ = '>';
-                }
-                if (c < (ptr->n - 1)) {
-                    *tokenwalk++ = ',';
-                    *tokenwalk++ = ' ';
-                }
-            }
-            *tokenwalk = '\0';
-            sasprintf(&errormessage, "Expected one of these tokens: %s",
-                      possible_tokens);
-            free(possible_tokens);
-
-            /* Contains the same amount of characters as 'input' has, but with
-             * the unparseable part highlighted using ^ characters. */
-            char *position = smalloc(len + 1);
-            for (const char *copywalk = input; *copywalk != '\0'; copywalk++)
-                position[(copywalk - input)] = (copywalk >= walk ? '^' : ' ');
-            position[len] = '\0';
-
-            ELOG("%s\n", errormessage);
-            ELOG("Your command: %s\n", input);
-            ELOG("              %s\n", position);
-
-            result->parse_error = true;
-            result->error_message = errormessage;
-
-            /* Format this error message as a JSON reply. */
-            y(map_open);
-            ystr("success");
-            y(bool, false);
-            /* We set parse_error to true to distinguish this from other
-             * errors. i3-nagbar is spawned upon keypresses only for parser
-             * errors. */
-            ystr("parse_error");
-            y(bool, true);
-            ystr("error");
-            ystr(errormessage);
-            ystr("input");
-            ystr(input);
-            ystr("errorposition");
-            ystr(position);
-            y(map_close);
-
-            free(position);
             clear_stack();
-            break;
+            return walk;
         }
     }
 
+    return NULL;
+}
+
+/*
+ * Parses and executes the given command. If a caller-allocated yajl_gen is
+ * passed, a json reply will be generated in the format specified by the ipc
+ * protocol. Pass NULL if no json reply is required.
+ *
+ * Free the returned CommandResult with command_result_free().
+ */
+CommandResult *parse_command(const char *input, yajl_gen gen) {
+    DLOG("COMMAND: *%s*\n", input);
+    state = INITIAL;
+    CommandResult *result = scalloc(sizeof(CommandResult));
+
+    /* A YAJL JSON generator used for formatting replies. */
+    command_output.json_gen = gen;
+
+    y(array_open);
+    command_output.needs_tree_render = false;
+
+    const size_t len = strlen(input);
+    int c;
+    const cmdp_token *token;
+
+// TODO: make this testable
+#ifndef TEST_PARSER
+    cmd_criteria_init(&current_match, &subcommand_output);
+#endif
+
+    const char *walk = walk_command(input, NULL);
+    if (walk != NULL) {
+        cmdp_token_ptr *ptr = &(tokens[state]);
+
+        /* Figure out how much memory we will need to fill in the names of
+         * all tokens afterwards. */
+        int tokenlen = 0;
+        for (c = 0; c < ptr->n; c++)
+            tokenlen += strlen(ptr->array[c].name) + strlen("'', ");
+
+        /* Build up a decent error message. We include the problem, the
+         * full input, and underline the position where the parser
+         * currently is. */
+        char *errormessage;
+        char *possible_tokens = smalloc(tokenlen + 1);
+        char *tokenwalk = possible_tokens;
+        for (c = 0; c < ptr->n; c++) {
+            token = &(ptr->array[c]);
+            if (token->kind == TOKEN_LITERAL) {
+                /* A literal is copied to the error message enclosed with
+                 * single quotes. */
+                *tokenwalk++ = '\'';
+                strcpy(tokenwalk, token->name + 1);
+                tokenwalk += strlen(token->name + 1);
+                *tokenwalk++ = '\'';
+            } else {
+                /* Any other token is copied to the error message enclosed
+                 * with angle brackets. */
+                *tokenwalk++ = '<';
+                strcpy(tokenwalk, token->name);
+                tokenwalk += strlen(token->name);
+                *tokenwalk++ = '>';
+            }
+            if (c < (ptr->n - 1)) {
+                *tokenwalk++ = ',';
+                *tokenwalk++ = ' ';
+            }
+        }
+        *tokenwalk = '\0';
+        sasprintf(&errormessage, "Expected one of these tokens: %s",
+                  possible_tokens);
+        free(possible_tokens);
+
+        /* Contains the same amount of characters as 'input' has, but with
+         * the unparseable part highlighted using ^ characters. */
+        char *position = smalloc(len + 1);
+        for (const char *copywalk = input; *copywalk != '\0'; copywalk++)
+            position[(copywalk - input)] = (copywalk >= walk ? '^' : ' ');
+        position[len] = '\0';
+
+        ELOG("%s\n", errormessage);
+        ELOG("Your command: %s\n", input);
+        ELOG("              %s\n", position);
+
+        result->parse_error = true;
+        result->error_message = errormessage;
+
+        /* Format this error message as a JSON reply. */
+        y(map_open);
+        ystr("success");
+        y(bool, false);
+        /* We set parse_error to true to distinguish this from other
+         * errors. i3-nagbar is spawned upon keypresses only for parser
+         * errors. */
+        ystr("parse_error");
+        y(bool, true);
+        ystr("error");
+        ystr(errormessage);
+        ystr("input");
+        ystr(input);
+        ystr("errorposition");
+        ystr(position);
+        y(map_close);
+
+        free(position);
+    }
+
     y(array_close);
 
     result->needs_tree_render = command_output.needs_tree_render;
     return result;
 }
 
+#ifndef TEST_PARSER
+/*
+ * Parses the given command into a program which command_program_run() can
+ * execute any number of times without parsing the command again. Returns
+ * NULL if the command cannot be parsed, use parse_command() to report the
+ * error in that case.
+ *
+ * Must not be called while a command is being executed, since the parser
+ * state is shared with parse_command().
+ *
+ */
+CommandProgram *command_program_new(const char *input) {
+    CommandProgram *program = scalloc(sizeof(CommandProgram));
+    program->input = sstrdup(input);
+    program->refcount = 1;
+
+    state = INITIAL;
+    if (walk_command(input, program) != NULL) {
+        command_program_free(program);
+        return NULL;
+    }
+
+    DLOG("Parsed command \"%s\" into %d calls\n", input, program->n_ops);
+    return program;
+}
+
+/*
+ * Executes the given program like parse_command() would execute its command
+ * (without generating a JSON reply). If con is not NULL, the command is
+ * executed with that container selected, like a [con_id=…] prefix would.
+ *
+ * Free the returned CommandResult with command_result_free().
+ *
+ */
+CommandResult *command_program_run(CommandProgram *program, Con *con) {
+    DLOG("COMMAND (pre-parsed): *%s*\n", program->input);
+    CommandResult *result = scalloc(sizeof(CommandResult));
+
+    command_output.json_gen = NULL;
+    command_output.needs_tree_render = false;
+
+    cmd_criteria_init(&current_match, &subcommand_output);
+    if (con != NULL) {
+        current_match.con_id = con;
+        cmd_criteria_match_windows(&current_match, &subcommand_output);
+    }
+
+    for (int i = 0; i < program->n_ops; i++) {
+        const struct command_op *op = &(program->ops[i]);
+        if (op->call_identifier == OP_CRITERIA_INIT) {
+            cmd_criteria_init(&current_match, &subcommand_output);
+            continue;
+        }
+
+        /* The called functions get their own copies of the arguments, just
+         * like when parsing. */
+        for (int c = 0; c < op->n_args; c++)
+            push_string(op->args[c].identifier, sstrdup(op->args[c].str));
+
+        subcommand_output.json_gen = NULL;
+        subcommand_output.needs_tree_render = false;
+        GENERATED_call(op->call_identifier, &subcommand_output);
+        if (subcommand_output.needs_tree_render)
+            command_output.needs_tree_render = true;
+        clear_stack();
+    }
+
+    result->needs_tree_render = command_output.needs_tree_render;
+    return result;
+}
+
+/*
+ * Returns a new reference to the given program (which may be NULL).
+ *
+ */
+CommandProgram *command_program_ref(CommandProgram *program) {
+    if (program != NULL)
+        program->refcount++;
+    return program;
+}
+
+/*
+ * Drops a reference to the given program, freeing it once it is no longer
+ * referenced.
+ *
+ */
+void command_program_free(CommandProgram *program) {
+    if (program == NULL || --(program->refcount) > 0)
+        return;
+
+    for (int i = 0; i < program->n_ops; i++)
+        for (int c = 0; c < program->ops[i].n_args; c++)
+            free(program->ops[i].args[c].str);
+    FREE(program->ops);
+    FREE(program->input);
+    FREE(program);
+}
+#endif
+
 /*
  * Frees a CommandResult
  */
@@ -452,6 +640,9 @@ void command_result_free(CommandResult *result) {
 
 #ifdef TEST_PARSER
 
+/* The tests check the debug output, so DLOG() is always enabled. */
+bool debuglog_enabled = true;
+
 /*
  * Logs the given message to stdout while prefixing the current time to it,
  * but only if debug logging was activated.
@@ -467,6 +658,15 @@ void debuglog(char *fmt, ...) {
     va_end(args);
 }
 
+void debuglog_at(const char *file, const char *function, int line, char *fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+    fprintf(stdout, "# %s:%s:%d - ", file, function, line);
+    vfprintf(stdout, fmt, args);
+    va_end(args);
+}
+
 void errorlog(char *fmt, ...) {
     va_list args;
 
@@ -30,6 +30,22 @@ void con_force_split_parents_redraw(Con *con) {
     }
 }
 
+/*
+ * Marks the workspace containing the given container as dirty, so that the
+ * next render recomputes the gaps of its containers instead of using the
+ * cached ones. Has to be called whenever the tree structure, a layout, a
+ * fullscreen mode or the gaps change. Containers outside of a workspace
+ * (outputs, dockareas, the root container) invalidate the whole tree.
+ *
+ */
+void con_invalidate(Con *con) {
+    Con *ws = (con == NULL ? NULL : con_get_workspace(con));
+    if (ws != NULL)
+        ws->dirty = true;
+    else if (croot != NULL)
+        croot->dirty = true;
+}
+
 /*
  * Create a new container (and attach it to the given parent, if not NULL).
  * This function only initializes the data structures.
@@ -42,6 +58,7 @@ Con *con_new_skeleton(Con *parent, i3Window *window) {
     new->aspect_ratio = 0.0;
     new->type = CT_CON;
     new->window = window;
+    con_index_add_window(new);
     new->border_style = config.default_border;
     new->current_border_width = -1;
     if (window)
@@ -157,6 +174,9 @@ add_to_focus_head:
      * to focus them. */
     TAILQ_INSERT_TAIL(focus_head, con, focused);
     con_force_split_parents_redraw(con);
+    con_invalidate(con);
+    tree_diff_changed(con, TC_PARENT);
+    tree_diff_changed(con->parent, (con->type == CT_FLOATING_CON ? TC_FLOATING_NODES : TC_NODES));
 }
 
 /*
@@ -179,6 +199,9 @@ void con_attach(Con *con, Con *parent, bool ignore_focus) {
  */
 void con_detach(Con *con) {
     con_force_split_parents_redraw(con);
+    con_invalidate(con);
+    tree_diff_changed(con, TC_PARENT);
+    tree_diff_changed(con->parent, (con->type == CT_FLOATING_CON ? TC_FLOATING_NODES : TC_NODES));
     if (con->type == CT_FLOATING_CON) {
         TAILQ_REMOVE(&(con->parent->floating_head), con, floating_windows);
         TAILQ_REMOVE(&(con->parent->focus_head), con, focused);
@@ -466,11 +489,16 @@ bool con_inside_focused(Con *con) {
  *
  */
 Con *con_by_window_id(xcb_window_t window) {
-    Con *con;
-    TAILQ_FOREACH(con, &all_cons, all_cons)
-    if (con->window != NULL && con->window->id == window)
-        return con;
-    return NULL;
+    Con *con = con_index_get_by_window(window);
+#ifdef DEBUG_CON_INDEX
+    /* Verify that the index is consistent with the list of containers. */
+    Con *walk;
+    TAILQ_FOREACH(walk, &all_cons, all_cons)
+    if (walk->window != NULL && walk->window->id == window)
+        break;
+    assert(walk == con);
+#endif
+    return con;
 }
 
 /*
@@ -479,11 +507,16 @@ Con *con_by_window_id(xcb_window_t window) {
  *
  */
 Con *con_by_frame_id(xcb_window_t frame) {
-    Con *con;
-    TAILQ_FOREACH(con, &all_cons, all_cons)
-    if (con->frame == frame)
-        return con;
-    return NULL;
+    Con *con = con_index_get_by_frame(frame);
+#ifdef DEBUG_CON_INDEX
+    /* Verify that the index is consistent with the list of containers. */
+    Con *walk;
+    TAILQ_FOREACH(walk, &all_cons, all_cons)
+    if (walk->frame == frame)
+        break;
+    assert(walk == con);
+#endif
+    return con;
 }
 
 /*
@@ -492,13 +525,52 @@ Con *con_by_frame_id(xcb_window_t frame) {
  *
  */
 Con *con_by_mark(const char *mark) {
-    Con *con;
-    TAILQ_FOREACH(con, &all_cons, all_cons) {
-        if (con->mark != NULL && strcmp(con->mark, mark) == 0)
-            return con;
-    }
+    Con *con = con_index_get_by_mark(mark);
+#ifdef DEBUG_CON_INDEX
+    /* Verify that the index is consistent with the list of containers. */
+    Con *walk;
+    TAILQ_FOREACH(walk, &all_cons, all_cons)
+    if (walk->mark != NULL && strcmp(walk->mark, mark) == 0)
+        break;
+    assert(walk == con);
+#endif
+    return con;
+}
 
-    return NULL;
+/*
+ * Assigns the given mark to the container. Since marks are unique, the mark is
+ * removed from any other container which currently has it.
+ *
+ */
+void con_mark(Con *con, const char *mark) {
+    Con *previous = con_by_mark(mark);
+    if (previous == con)
+        return;
+
+    if (previous != NULL)
+        con_unmark(previous);
+    con_unmark(con);
+
+    con->mark = sstrdup(mark);
+    con->mark_changed = true;
+    tree_diff_changed(con, TC_MARK);
+    con_index_add_mark(con);
+    TAILQ_INSERT_TAIL(&marked_cons, con, marked_cons);
+}
+
+/*
+ * Removes the mark of the given container, if it has one.
+ *
+ */
+void con_unmark(Con *con) {
+    if (con->mark == NULL)
+        return;
+
+    con_index_remove_mark(con);
+    TAILQ_REMOVE(&marked_cons, con, marked_cons);
+    FREE(con->mark);
+    con->mark_changed = true;
+    tree_diff_changed(con, TC_MARK);
 }
 
 /*
@@ -591,6 +663,10 @@ void con_fix_percent(Con *con) {
     Con *child;
     int children = con_num_children(con);
 
+    /* Callers which insert containers into the tree manually (without
+     * con_attach()) always fix the percentages afterwards. */
+    con_invalidate(con);
+
     // calculate how much we have distributed and how many containers
     // with a percentage set we have
     double total = 0.0;
@@ -654,6 +730,8 @@ void con_toggle_fullscreen(Con *con, int fullscreen_mode) {
  */
 static void con_set_fullscreen_mode(Con *con, fullscreen_mode_t fullscreen_mode) {
     con->fullscreen_mode = fullscreen_mode;
+    con_invalidate(con);
+    tree_diff_changed(con, TC_FULLSCREEN);
 
     DLOG("mode now: %d\n", con->fullscreen_mode);
 
@@ -1357,6 +1435,9 @@ int con_border_style(Con *con) {
  *
  */
 void con_set_border_style(Con *con, int border_style, int border_width) {
+    con_invalidate(con);
+    tree_diff_changed(con, TC_BORDER);
+
     /* Handle the simple case: non-floating containerns */
     if (!con_is_floating(con)) {
         con->border_style = border_style;
@@ -1408,6 +1489,9 @@ void con_set_layout(Con *con, layout_t layout) {
     if (con->type != CT_WORKSPACE)
         con = con->parent;
 
+    con_invalidate(con);
+    tree_diff_changed(con, TC_LAYOUT);
+
     /* We fill in last_split_layout when switching to a different layout
      * since there are many places in the code that don’t use
      * con_set_layout(). */
@@ -1557,21 +1641,27 @@ static void con_on_remove_child(Con *con) {
     if (con->type == CT_WORKSPACE) {
         if (TAILQ_EMPTY(&(con->focus_head)) && !workspace_is_visible(con)) {
             LOG("Closing old workspace (%p / %s), it is empty\n", con, con->name);
-            yajl_gen gen = ipc_marshal_workspace_event("empty", con, NULL);
+            /* The event has to be generated before the workspace is freed. */
+            yajl_gen gen = NULL;
+            if (ipc_has_event_subscribers(I3_IPC_EVENT_WORKSPACE))
+                gen = ipc_marshal_workspace_event("empty", con, NULL);
             tree_close(con, DONT_KILL_WINDOW, false, false);
 
-            const unsigned char *payload;
-            ylength length;
-            y(get_buf, &payload, &length);
-            ipc_send_event("workspace", I3_IPC_EVENT_WORKSPACE, (const char *)payload);
+            if (gen != NULL) {
+                const unsigned char *payload;
+                ylength length;
+                y(get_buf, &payload, &length);
+                ipc_send_event("workspace", I3_IPC_EVENT_WORKSPACE, (const char *)payload);
 
-            y(free);
+                y(free);
+            }
         }
         return;
     }
 
     con_force_split_parents_redraw(con);
     con->urgent = con_has_urgent_child(con);
+    tree_diff_changed(con, TC_URGENT);
     con_update_parents_urgency(con);
 
     /* TODO: check if this container would swallow any other client and
@@ -1744,6 +1834,7 @@ void con_update_parents_urgency(Con *con) {
             if (!con_has_urgent_child(parent))
                 parent->urgent = false;
         }
+        tree_diff_changed(parent, TC_URGENT);
         parent = parent->parent;
     }
 }
@@ -1785,6 +1876,7 @@ void con_set_urgency(Con *con, bool urgent) {
 
     if (con->urgent != old_urgent) {
         LOG("Urgency flag changed to %d\n", con->urgent);
+        tree_diff_changed(con, TC_URGENT);
         ipc_send_window_event("urgent", con);
     }
 }
@@ -0,0 +1,260 @@
+#undef I3__FILE__
+#define I3__FILE__ "con_index.c"
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * con_index.c: Hash indexes which map X11 window IDs (client windows and
+ *              frames) and marks to their containers, so that looking up the
+ *              container for an X11 event or a mark does not require walking
+ *              all_cons.
+ *
+ */
+#include "all.h"
+
+/* Number of slots an index starts out with once the first entry is added.
+ * Has to be a power of two. */
+#define CON_INDEX_INITIAL_SIZE 64
+
+struct con_index_slot {
+    /* Full hash of the key, so that we never need to re-hash when growing
+     * or shifting entries. */
+    uint32_t hash;
+    /* The indexed container, NULL if the slot is empty. */
+    Con *con;
+};
+
+/*
+ * An open-addressing hash table using linear probing. The key of each entry
+ * is derived from the container itself (its window ID, frame ID or mark), so
+ * only the container and the hash of its key are stored. The table is kept at
+ * most half full so that probe sequences stay short. Deletion shifts the
+ * following entries of the cluster back instead of leaving tombstones.
+ *
+ */
+struct con_index {
+    struct con_index_slot *slots;
+    uint32_t size;
+    uint32_t used;
+    /* 32 - log2(size), used to take the upper bits of the mixed hash. */
+    int shift;
+    /* Returns true if the key of the given container equals 'key'. */
+    bool (*key_matches)(Con *con, const void *key);
+};
+
+static bool window_matches(Con *con, const void *key) {
+    return (con->window != NULL && con->window->id == *(const xcb_window_t *)key);
+}
+
+static bool frame_matches(Con *con, const void *key) {
+    return (con->frame == *(const xcb_window_t *)key);
+}
+
+static bool mark_matches(Con *con, const void *key) {
+    return (con->mark != NULL && strcmp(con->mark, (const char *)key) == 0);
+}
+
+static struct con_index window_index = {.key_matches = window_matches};
+static struct con_index frame_index = {.key_matches = frame_matches};
+static struct con_index mark_index = {.key_matches = mark_matches};
+
+/*
+ * 32 bit FNV-1a, used for marks.
+ *
+ */
+static uint32_t hash_string(const char *str) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *walk = (const unsigned char *)str; *walk != '\0'; walk++) {
+        hash ^= *walk;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*
+ * Fibonacci hashing: X11 IDs are handed out sequentially from a per-client
+ * base, so the interesting bits are spread over the whole word. Multiplying
+ * mixes them into the upper bits, which we use as the slot number.
+ *
+ */
+static uint32_t con_index_home(struct con_index *index, uint32_t hash) {
+    return (uint32_t)(hash * 2654435769u) >> index->shift;
+}
+
+static struct con_index_slot *con_index_find(struct con_index *index, uint32_t hash, const void *key) {
+    if (index->size == 0)
+        return NULL;
+
+    const uint32_t mask = index->size - 1;
+    for (uint32_t i = con_index_home(index, hash);; i = (i + 1) & mask) {
+        struct con_index_slot *slot = &(index->slots[i]);
+        if (slot->con == NULL)
+            return NULL;
+        if (slot->hash == hash && index->key_matches(slot->con, key))
+            return slot;
+    }
+}
+
+static void con_index_insert_slot(struct con_index *index, uint32_t hash, Con *con) {
+    const uint32_t mask = index->size - 1;
+    uint32_t i = con_index_home(index, hash);
+    while (index->slots[i].con != NULL)
+        i = (i + 1) & mask;
+
+    index->slots[i].hash = hash;
+    index->slots[i].con = con;
+    index->used++;
+}
+
+static void con_index_grow(struct con_index *index) {
+    struct con_index_slot *old_slots = index->slots;
+    uint32_t old_size = index->size;
+
+    index->size = (old_size == 0 ? CON_INDEX_INITIAL_SIZE : old_size * 2);
+    index->slots = scalloc(index->size * sizeof(struct con_index_slot));
+    index->used = 0;
+    index->shift = 32;
+    for (uint32_t size = index->size; size > 1; size >>= 1)
+        index->shift--;
+
+    for (uint32_t i = 0; i < old_size; i++)
+        if (old_slots[i].con != NULL)
+            con_index_insert_slot(index, old_slots[i].hash, old_slots[i].con);
+
+    free(old_slots);
+}
+
+/*
+ * Inserts (or replaces) the mapping key → con.
+ *
+ */
+static void con_index_put(struct con_index *index, uint32_t hash, const void *key, Con *con) {
+    struct con_index_slot *slot = con_index_find(index, hash, key);
+    if (slot != NULL) {
+        slot->con = con;
+        return;
+    }
+
+    if ((index->used + 1) * 2 > index->size)
+        con_index_grow(index);
+
+    con_index_insert_slot(index, hash, con);
+}
+
+/*
+ * Removes the mapping for key, but only if it still points to con (the key
+ * might have been handed to another container in the meantime, e.g. for
+ * sticky windows).
+ *
+ */
+static void con_index_delete(struct con_index *index, uint32_t hash, const void *key, Con *con) {
+    struct con_index_slot *slot = con_index_find(index, hash, key);
+    if (slot == NULL || slot->con != con)
+        return;
+
+    const uint32_t mask = index->size - 1;
+    uint32_t hole = slot - index->slots;
+    for (uint32_t i = (hole + 1) & mask; index->slots[i].con != NULL; i = (i + 1) & mask) {
+        /* The entry in slot i can fill the hole unless its home slot lies
+         * cyclically between the hole and i. */
+        uint32_t home = con_index_home(index, index->slots[i].hash);
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            index->slots[hole] = index->slots[i];
+            hole = i;
+        }
+    }
+
+    index->slots[hole].hash = 0;
+    index->slots[hole].con = NULL;
+    index->used--;
+}
+
+/*
+ * Adds the client window of the given container to the window index. Has to
+ * be called whenever con->window is set.
+ *
+ */
+void con_index_add_window(Con *con) {
+    if (con->window != NULL)
+        con_index_put(&window_index, con->window->id, &(con->window->id), con);
+}
+
+/*
+ * Removes the client window of the given container from the window index.
+ * Has to be called before con->window is freed or handed to another
+ * container.
+ *
+ */
+void con_index_remove_window(Con *con) {
+    if (con->window != NULL)
+        con_index_delete(&window_index, con->window->id, &(con->window->id), con);
+}
+
+/*
+ * Adds the frame of the given container to the frame index. Called from
+ * x_con_init() once the frame has been created.
+ *
+ */
+void con_index_add_frame(Con *con) {
+    if (con->frame != XCB_NONE)
+        con_index_put(&frame_index, con->frame, &(con->frame), con);
+}
+
+/*
+ * Removes the frame of the given container from the frame index. Called from
+ * x_con_kill() when the frame is destroyed.
+ *
+ */
+void con_index_remove_frame(Con *con) {
+    if (con->frame != XCB_NONE)
+        con_index_delete(&frame_index, con->frame, &(con->frame), con);
+}
+
+/*
+ * Adds the mark of the given container to the mark index. Called from
+ * con_mark().
+ *
+ */
+void con_index_add_mark(Con *con) {
+    if (con->mark != NULL)
+        con_index_put(&mark_index, hash_string(con->mark), con->mark, con);
+}
+
+/*
+ * Removes the mark of the given container from the mark index. Has to be
+ * called before con->mark is freed.
+ *
+ */
+void con_index_remove_mark(Con *con) {
+    if (con->mark != NULL)
+        con_index_delete(&mark_index, hash_string(con->mark), con->mark, con);
+}
+
+/*
+ * Returns the container whose client window has the given ID or NULL.
+ *
+ */
+Con *con_index_get_by_window(xcb_window_t window) {
+    struct con_index_slot *slot = con_index_find(&window_index, window, &window);
+    return (slot == NULL ? NULL : slot->con);
+}
+
+/*
+ * Returns the container whose frame has the given ID or NULL.
+ *
+ */
+Con *con_index_get_by_frame(xcb_window_t frame) {
+    struct con_index_slot *slot = con_index_find(&frame_index, frame, &frame);
+    return (slot == NULL ? NULL : slot->con);
+}
+
+/*
+ * Returns the container with the given mark or NULL.
+ *
+ */
+Con *con_index_get_by_mark(const char *mark) {
+    struct con_index_slot *slot = con_index_find(&mark_index, hash_string(mark), mark);
+    return (slot == NULL ? NULL : slot->con);
+}
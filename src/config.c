@@ -146,8 +146,10 @@ void load_configuration(xcb_connection_t *conn, const char *override_configpath,
 
         /* Invalidate pixmap caches in case font or colors changed */
         Con *con;
-        TAILQ_FOREACH(con, &all_cons, all_cons)
-        FREE(con->deco_render_params);
+        TAILQ_FOREACH(con, &all_cons, all_cons) {
+            FREE(con->deco_render_params);
+        }
+        x_invalidate_deco_strips();
 
         /* Get rid of the current font */
         free_font();
@@ -213,6 +215,10 @@ void load_configuration(xcb_connection_t *conn, const char *override_configpath,
     if (config.zero_disp_exit_timer_ms == 0)
         config.zero_disp_exit_timer_ms = 500;
 
+    /* Set default IPC buffer limit to 16 MiB */
+    if (config.ipc_buffer_limit == 0)
+        config.ipc_buffer_limit = 16 * 1024 * 1024;
+
     parse_configuration(override_configpath, true);
 
     if (reload) {
@@ -231,6 +237,7 @@ void load_configuration(xcb_connection_t *conn, const char *override_configpath,
     if (reload) {
         x_deco_recurse(croot);
         xcb_flush(conn);
+        con_invalidate(croot);
     }
 
 #if 0
@@ -465,6 +465,14 @@ CFGFUN(ipc_socket, const char *path) {
     config.ipc_socket_path = sstrdup(path);
 }
 
+CFGFUN(ipc_buffer_limit, const long size_kb) {
+    if (size_kb <= 0) {
+        ELOG("ipc_buffer_limit must be positive, ignoring %ld kb\n", size_kb);
+        return;
+    }
+    config.ipc_buffer_limit = (size_t)size_kb * 1024;
+}
+
 CFGFUN(restart_state, const char *path) {
     config.restart_state_path = sstrdup(path);
 }
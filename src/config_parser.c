@@ -65,6 +65,11 @@ typedef struct token {
     union {
         uint16_t call_identifier;
     } extra;
+    /* How to match this token, so that the name does not have to be
+     * compared. */
+    cmdp_token_kind kind;
+    /* The length of a literal, without the leading single quote. */
+    int length;
 } cmdp_token;
 
 typedef struct tokenptr {
@@ -349,16 +354,20 @@ struct ConfigResultIR *parse_config(const char *input, struct context *context)
         //printf("remaining input: %s\n", walk);
 
         cmdp_token_ptr *ptr = &(tokens[state]);
+        /* Only the tokens which can match the first character need to be
+         * tried, see generate-command-parser.pl. */
+        int n;
+        const uint8_t *candidates = GENERATED_candidates(state, *walk, &n);
         token_handled = false;
-        for (c = 0; c < ptr->n; c++) {
-            token = &(ptr->array[c]);
+        for (c = 0; c < n; c++) {
+            token = &(ptr->array[candidates[c]]);
 
             /* A literal. */
-            if (token->name[0] == '\'') {
-                if (strncasecmp(walk, token->name + 1, strlen(token->name) - 1) == 0) {
+            if (token->kind == TOKEN_LITERAL) {
+                if (strncasecmp(walk, token->name + 1, token->length) == 0) {
                     if (token->identifier != NULL)
                         push_string(token->identifier, token->name + 1);
-                    walk += strlen(token->name) - 1;
+                    walk += token->length;
                     next_state(token);
                     token_handled = true;
                     break;
@@ -366,7 +375,7 @@ struct ConfigResultIR *parse_config(const char *input, struct context *context)
                 continue;
             }
 
-            if (strcmp(token->name, "number") == 0) {
+            if (token->kind == TOKEN_NUMBER) {
                 /* Handle numbers. We only accept decimal numbers for now. */
                 char *end = NULL;
                 errno = 0;
@@ -389,8 +398,8 @@ struct ConfigResultIR *parse_config(const char *input, struct context *context)
                 break;
             }
 
-            if (strcmp(token->name, "string") == 0 ||
-                strcmp(token->name, "word") == 0) {
+            if (token->kind == TOKEN_STRING ||
+                token->kind == TOKEN_WORD) {
                 const char *beginning = walk;
                 /* Handle quoted strings (or words). */
                 if (*walk == '"') {
@@ -399,7 +408,7 @@ struct ConfigResultIR *parse_config(const char *input, struct context *context)
                     while (*walk != '\0' && (*walk != '"' || *(walk - 1) == '\\'))
                         walk++;
                 } else {
-                    if (token->name[0] == 's') {
+                    if (token->kind == TOKEN_STRING) {
                         while (*walk != '\0' && *walk != '\r' && *walk != '\n')
                             walk++;
                     } else {
@@ -440,7 +449,7 @@ struct ConfigResultIR *parse_config(const char *input, struct context *context)
                 }
             }
 
-            if (strcmp(token->name, "line") == 0) {
+            if (token->kind == TOKEN_LINE) {
                 while (*walk != '\0' && *walk != '\n' && *walk != '\r')
                     walk++;
                 next_state(token);
@@ -450,7 +459,7 @@ struct ConfigResultIR *parse_config(const char *input, struct context *context)
                 break;
             }
 
-            if (strcmp(token->name, "end") == 0) {
+            if (token->kind == TOKEN_END) {
                 //printf("checking for end: *%s*\n", walk);
                 if (*walk == '\0' || *walk == '\n' || *walk == '\r') {
                     next_state(token);
@@ -485,7 +494,7 @@ struct ConfigResultIR *parse_config(const char *input, struct context *context)
             char *tokenwalk = possible_tokens;
             for (c = 0; c < ptr->n; c++) {
                 token = &(ptr->array[c]);
-                if (token->name[0] == '\'') {
+                if (token->kind == TOKEN_LITERAL) {
                     /* A literal is copied to the error message enclosed with
                      * single quotes. */
                     *tokenwalk++ = '\'';
@@ -495,7 +504,7 @@ struct ConfigResultIR *parse_config(const char *input, struct context *context)
                 } else {
                     /* Skip error tokens in error messages, they are used
                      * internally only and might confuse users. */
-                    if (strcmp(token->name, "error") == 0)
+                    if (token->kind == TOKEN_ERROR)
                         continue;
                     /* Any other token is copied to the error message enclosed
                      * with angle brackets. */
@@ -592,7 +601,7 @@ struct ConfigResultIR *parse_config(const char *input, struct context *context)
             for (int i = statelist_idx - 1; (i >= 0) && !error_token_found; i--) {
                 cmdp_token_ptr *errptr = &(tokens[statelist[i]]);
                 for (int j = 0; j < errptr->n; j++) {
-                    if (strcmp(errptr->array[j].name, "error") != 0)
+                    if (errptr->array[j].kind != TOKEN_ERROR)
                         continue;
                     next_state(&(errptr->array[j]));
                     error_token_found = true;
@@ -616,6 +625,9 @@ struct ConfigResultIR *parse_config(const char *input, struct context *context)
 
 #ifdef TEST_PARSER
 
+/* The tests check the debug output, so DLOG() is always enabled. */
+bool debuglog_enabled = true;
+
 /*
  * Logs the given message to stdout while prefixing the current time to it,
  * but only if debug logging was activated.
@@ -631,6 +643,15 @@ void debuglog(char *fmt, ...) {
     va_end(args);
 }
 
+void debuglog_at(const char *file, const char *function, int line, char *fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+    fprintf(stdout, "# %s:%s:%d - ", file, function, line);
+    vfprintf(stdout, fmt, args);
+    va_end(args);
+}
+
 void errorlog(char *fmt, ...) {
     va_list args;
 
@@ -160,6 +160,7 @@ void floating_enable(Con *con, bool automatic) {
 
     /* 1: detach the container from its parent */
     /* TODO: refactor this with tree_close() */
+    tree_diff_changed(con->parent, TC_NODES);
     TAILQ_REMOVE(&(con->parent->nodes_head), con, nodes);
     TAILQ_REMOVE(&(con->parent->focus_head), con, focused);
 
@@ -180,6 +181,7 @@ void floating_enable(Con *con, bool automatic) {
      * closed in tree_close()) even though it’s not. */
     TAILQ_INSERT_TAIL(&(ws->floating_head), nc, floating_windows);
     TAILQ_INSERT_TAIL(&(ws->focus_head), nc, focused);
+    tree_diff_changed(ws, TC_FLOATING_NODES);
 
     /* check if the parent container is empty and close it if so */
     if ((con->parent->type == CT_CON || con->parent->type == CT_FLOATING_CON) &&
@@ -219,6 +221,7 @@ void floating_enable(Con *con, bool automatic) {
     con->parent = nc;
     con->percent = 1.0;
     con->floating = FLOATING_USER_ON;
+    tree_diff_changed(con, TC_PARENT | TC_FLOATING | TC_BORDER);
 
     /* 4: set the border style as specified with new_float */
     if (automatic)
@@ -328,6 +331,7 @@ void floating_disable(Con *con, bool automatic) {
     TAILQ_REMOVE(&(con->parent->focus_head), con, focused);
 
     /* 2: kill parent container */
+    tree_diff_changed(con->parent->parent, TC_FLOATING_NODES);
     TAILQ_REMOVE(&(con->parent->parent->floating_head), con->parent, floating_windows);
     TAILQ_REMOVE(&(con->parent->parent->focus_head), con->parent, focused);
     tree_close(con->parent, DONT_KILL_WINDOW, true, false);
@@ -347,6 +351,7 @@ void floating_disable(Con *con, bool automatic) {
     con->percent = 0.0;
 
     con->floating = FLOATING_USER_OFF;
+    tree_diff_changed(con, TC_FLOATING);
 
     con_attach(con, con->parent, false);
 
@@ -385,6 +390,7 @@ void floating_raise_con(Con *con) {
     DLOG("Raising floating con %p / %s\n", con, con->name);
     TAILQ_REMOVE(&(con->parent->floating_head), con, floating_windows);
     TAILQ_INSERT_TAIL(&(con->parent->floating_head), con, floating_windows);
+    tree_diff_changed(con->parent, TC_FLOATING_NODES);
 }
 
 /*
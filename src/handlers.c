@@ -27,7 +27,66 @@ int xkb_current_group;
 /* After mapping/unmapping windows, a notify event is generated. However, we don’t want it,
    since it’d trigger an infinite loop of switching between the different windows when
    changing workspaces */
-static SLIST_HEAD(ignore_head, Ignore_Event) ignore_events;
+
+/* Number of hash buckets for ignored events. Sequence numbers are handed out
+ * consecutively, so their lower bits are used as the hash. Has to be a power
+ * of two. */
+#define IGNORE_BUCKETS 64
+
+/* Seconds after which an ignored sequence number gets garbage collected. */
+#define IGNORE_TIMEOUT 5.0
+
+static LIST_HEAD(ignore_head, Ignore_Event) ignore_buckets[IGNORE_BUCKETS];
+static TAILQ_HEAD(ignore_order_head, Ignore_Event) ignore_order = TAILQ_HEAD_INITIALIZER(ignore_order);
+static struct ev_timer ignore_timer;
+
+/*
+ * Garbage collects all ignored events which are older than IGNORE_TIMEOUT and
+ * re-arms the timer for the oldest remaining one. The timer is only running
+ * while there are ignored events.
+ *
+ */
+static void ignore_timer_cb(EV_P_ ev_timer *w, int revents) {
+    const double now = ev_now(main_loop);
+    struct Ignore_Event *event;
+
+    while ((event = TAILQ_FIRST(&ignore_order)) != NULL &&
+           (now - event->added) >= IGNORE_TIMEOUT) {
+        TAILQ_REMOVE(&ignore_order, event, ignore_order);
+        LIST_REMOVE(event, ignore_events);
+        free(event);
+    }
+
+    if (event != NULL) {
+        ev_timer_set(&ignore_timer, event->added + IGNORE_TIMEOUT - now, 0.);
+        ev_timer_start(main_loop, &ignore_timer);
+    }
+}
+
+/*
+ * Adds an entry for the given sequence to the hash table and arms the garbage
+ * collection timer.
+ *
+ */
+static struct Ignore_Event *ignore_event_new(const unsigned int sequence, const int response_type) {
+    struct Ignore_Event *event = scalloc(sizeof(struct Ignore_Event));
+
+    /* X11 events only contain the lower 16 bits of the sequence number,
+     * whereas cookies contain the full sequence number. */
+    event->sequence = (sequence & 0xFFFF);
+    event->response_type = response_type;
+    event->added = ev_now(main_loop);
+
+    LIST_INSERT_HEAD(&ignore_buckets[event->sequence & (IGNORE_BUCKETS - 1)], event, ignore_events);
+    TAILQ_INSERT_TAIL(&ignore_order, event, ignore_order);
+
+    if (!ev_is_active(&ignore_timer)) {
+        ev_timer_init(&ignore_timer, ignore_timer_cb, IGNORE_TIMEOUT, 0.);
+        ev_timer_start(main_loop, &ignore_timer);
+    }
+
+    return event;
+}
 
 /*
  * Adds the given sequence to the list of events which are ignored.
@@ -38,13 +97,42 @@ static SLIST_HEAD(ignore_head, Ignore_Event) ignore_events;
  *
  */
 void add_ignore_event(const int sequence, const int response_type) {
-    struct Ignore_Event *event = smalloc(sizeof(struct Ignore_Event));
+    ignore_event_new(sequence, response_type);
+}
 
-    event->sequence = sequence;
-    event->response_type = response_type;
-    event->added = time(NULL);
+/*
+ * Remembers that the request with the given sequence number was sent for the
+ * given window and may fail, see watched_request_failed(). Like ignored
+ * events, entries are garbage collected after 5 seconds.
+ *
+ */
+void add_watched_request(const unsigned int sequence, const xcb_window_t window) {
+    struct Ignore_Event *event = ignore_event_new(sequence, 0);
+    event->full_sequence = sequence;
+    event->window = window;
+}
+
+/*
+ * Returns the window of the watched request with the given (full) sequence
+ * number and forgets about the request, or XCB_NONE if the request was not
+ * watched.
+ *
+ */
+xcb_window_t watched_request_failed(const unsigned int full_sequence) {
+    struct Ignore_Event *event;
+
+    LIST_FOREACH(event, &ignore_buckets[full_sequence & (IGNORE_BUCKETS - 1)], ignore_events) {
+        if (event->window == XCB_NONE || event->full_sequence != full_sequence)
+            continue;
+
+        const xcb_window_t window = event->window;
+        TAILQ_REMOVE(&ignore_order, event, ignore_order);
+        LIST_REMOVE(event, ignore_events);
+        free(event);
+        return window;
+    }
 
-    SLIST_INSERT_HEAD(&ignore_events, event, ignore_events);
+    return XCB_NONE;
 }
 
 /*
@@ -52,20 +140,12 @@ void add_ignore_event(const int sequence, const int response_type) {
  *
  */
 bool event_is_ignored(const int sequence, const int response_type) {
+    const int masked = (sequence & 0xFFFF);
     struct Ignore_Event *event;
-    time_t now = time(NULL);
-    for (event = SLIST_FIRST(&ignore_events); event != SLIST_END(&ignore_events);) {
-        if ((now - event->added) > 5) {
-            struct Ignore_Event *save = event;
-            event = SLIST_NEXT(event, ignore_events);
-            SLIST_REMOVE(&ignore_events, save, Ignore_Event, ignore_events);
-            free(save);
-        } else
-            event = SLIST_NEXT(event, ignore_events);
-    }
 
-    SLIST_FOREACH(event, &ignore_events, ignore_events) {
-        if (event->sequence != sequence)
+    LIST_FOREACH(event, &ignore_buckets[masked & (IGNORE_BUCKETS - 1)], ignore_events) {
+        /* Watched requests are handled by watched_request_failed(). */
+        if (event->sequence != masked || event->window != XCB_NONE)
             continue;
 
         if (event->response_type != -1 &&
@@ -75,8 +155,6 @@ bool event_is_ignored(const int sequence, const int response_type) {
         /* instead of removing a sequence number we better wait until it gets
          * garbage collected. it may generate multiple events (there are multiple
          * enter_notifies for one configure_request, for example). */
-        //SLIST_REMOVE(&ignore_events, event, Ignore_Event, ignore_events);
-        //free(event);
         return true;
     }
 
@@ -556,10 +634,12 @@ static bool handle_windowname_change(void *data, xcb_connection_t *conn, uint8_t
 
     window_update_name(con->window, prop, false);
 
-    x_push_changes(croot);
+    tree_request_push();
 
-    if (window_name_changed(con->window, old_name))
+    if (window_name_changed(con->window, old_name)) {
+        tree_diff_changed(con, TC_NAME);
         ipc_send_window_event("title", con);
+    }
 
     FREE(old_name);
 
@@ -581,10 +661,12 @@ static bool handle_windowname_change_legacy(void *data, xcb_connection_t *conn,
 
     window_update_name_legacy(con->window, prop, false);
 
-    x_push_changes(croot);
+    tree_request_push();
 
-    if (window_name_changed(con->window, old_name))
+    if (window_name_changed(con->window, old_name)) {
+        tree_diff_changed(con, TC_NAME);
         ipc_send_window_event("title", con);
+    }
 
     FREE(old_name);
 
@@ -662,6 +744,9 @@ static void handle_expose_event(xcb_expose_event_t *event) {
 #define _NET_WM_MOVERESIZE_MOVE_KEYBOARD 10 /* move via keyboard */
 #define _NET_WM_MOVERESIZE_CANCEL 11        /* cancel operation */
 
+/* Defined with the property handlers below. */
+static void sync_pending_properties(void);
+
 /*
  * Handle client messages (EWMH)
  *
@@ -758,6 +843,13 @@ static void handle_client_message(xcb_client_message_event_t *event) {
     } else if (event->type == A_I3_SYNC) {
         xcb_window_t window = event->data.data32[0];
         uint32_t rnd = event->data.data32[1];
+
+        /* Property changes the client made before are only handled
+         * asynchronously and rendered later, but have to be visible once it
+         * gets our reply. */
+        sync_pending_properties();
+        tree_render_pending();
+
         DLOG("[i3 sync protocol] Sending random value %d back to X11 window 0x%08x\n", rnd, window);
 
         void *reply = scalloc(32);
@@ -1007,7 +1099,7 @@ static bool handle_normal_hints(void *data, xcb_connection_t *conn, uint8_t stat
 
 render_and_return:
     if (changed)
-        tree_render();
+        tree_request_render();
     FREE(reply);
     return true;
 }
@@ -1029,7 +1121,7 @@ static bool handle_hints(void *data, xcb_connection_t *conn, uint8_t state, xcb_
         reply = xcb_get_property_reply(conn, xcb_icccm_get_wm_hints(conn, window), NULL);
     window_update_hints(con->window, reply, &urgency_hint);
     con_set_urgency(con, urgency_hint);
-    tree_render();
+    tree_request_render();
 
     return true;
 }
@@ -1237,8 +1329,10 @@ static bool handle_strut_partial_change(void *data, xcb_connection_t *conn, uint
     con->parent = dockarea;
     TAILQ_INSERT_HEAD(&(dockarea->focus_head), con, focused);
     TAILQ_INSERT_HEAD(&(dockarea->nodes_head), con, nodes);
+    tree_diff_changed(con, TC_PARENT);
+    tree_diff_changed(dockarea, TC_NODES);
 
-    tree_render();
+    tree_request_render();
 
     return true;
 }
@@ -1286,9 +1380,36 @@ void property_handlers_init(void) {
     property_handlers[9].atom = A__NET_WM_WINDOW_TYPE;
 }
 
+/*
+ * A PropertyNotify whose property was not fetched yet or whose reply was not
+ * handled yet, see property_notify() and handle_pending_properties().
+ *
+ */
+struct pending_property {
+    xcb_window_t window;
+    xcb_atom_t atom;
+    uint8_t state;
+    struct property_handler_t *handler;
+    /* Whether the GetProperty request was sent. Deleted properties are not
+     * fetched, but still handled in order. */
+    bool sent;
+    xcb_get_property_cookie_t cookie;
+
+    TAILQ_ENTRY(pending_property) pending_properties;
+};
+
+static TAILQ_HEAD(pending_properties_head, pending_property) pending_properties =
+    TAILQ_HEAD_INITIALIZER(pending_properties);
+
+/*
+ * Queues the handling of a PropertyNotify. The property is only fetched when
+ * the current batch of events was handled, so that a window which changes a
+ * property several times in a row (e.g. a terminal updating its title) only
+ * costs one request, which returns the latest value.
+ *
+ */
 static void property_notify(uint8_t state, xcb_window_t window, xcb_atom_t atom) {
     struct property_handler_t *handler = NULL;
-    xcb_get_property_reply_t *propr = NULL;
 
     for (size_t c = 0; c < sizeof(property_handlers) / sizeof(struct property_handler_t); c++) {
         if (property_handlers[c].atom != atom)
@@ -1303,14 +1424,112 @@ static void property_notify(uint8_t state, xcb_window_t window, xcb_atom_t atom)
         return;
     }
 
-    if (state != XCB_PROPERTY_DELETE) {
-        xcb_get_property_cookie_t cookie = xcb_get_property(conn, 0, window, atom, XCB_GET_PROPERTY_TYPE_ANY, 0, handler->long_len);
-        propr = xcb_get_property_reply(conn, cookie, 0);
+    struct pending_property *pending;
+    TAILQ_FOREACH(pending, &pending_properties, pending_properties) {
+        if (pending->window == window && pending->atom == atom)
+            break;
+    }
+
+    if (pending != NULL && !pending->sent) {
+        pending->state = state;
+        return;
+    }
+
+    if (pending != NULL) {
+        /* The value we are waiting for is outdated already. */
+        if (pending->state != XCB_PROPERTY_DELETE)
+            xcb_discard_reply(conn, pending->cookie.sequence);
+        TAILQ_REMOVE(&pending_properties, pending, pending_properties);
+        free(pending);
+    }
+
+    pending = scalloc(sizeof(struct pending_property));
+    pending->window = window;
+    pending->atom = atom;
+    pending->state = state;
+    pending->handler = handler;
+    TAILQ_INSERT_TAIL(&pending_properties, pending, pending_properties);
+}
+
+/*
+ * Calls the property handlers for all replies which arrived, in the order of
+ * the PropertyNotify events. Stops at the first reply which did not arrive
+ * yet.
+ *
+ */
+static void handle_property_replies(void) {
+    struct pending_property *pending;
+
+    while ((pending = TAILQ_FIRST(&pending_properties)) != NULL && pending->sent) {
+        xcb_get_property_reply_t *propr = NULL;
+        if (pending->state != XCB_PROPERTY_DELETE) {
+            xcb_generic_error_t *error = NULL;
+            if (!xcb_poll_for_reply(conn, pending->cookie.sequence, (void **)&propr, &error))
+                break;
+            free(error);
+        }
+
+        TAILQ_REMOVE(&pending_properties, pending, pending_properties);
+
+        /* the handler will free() the reply unless it returns false */
+        if (!pending->handler->cb(NULL, conn, pending->state, pending->window, pending->atom, propr))
+            FREE(propr);
+        free(pending);
+    }
+}
+
+/*
+ * Handles the property replies which arrived and sends the requests for the
+ * properties which changed since the last call. Called before the event loop
+ * blocks, i.e. once per batch of events.
+ *
+ */
+void handle_pending_properties(void) {
+    struct pending_property *pending;
+
+    handle_property_replies();
+
+    bool deleted = false;
+    TAILQ_FOREACH(pending, &pending_properties, pending_properties) {
+        if (pending->sent)
+            continue;
+
+        if (pending->state != XCB_PROPERTY_DELETE)
+            pending->cookie = xcb_get_property(conn, 0, pending->window, pending->atom,
+                                               XCB_GET_PROPERTY_TYPE_ANY, 0, pending->handler->long_len);
+        else
+            deleted = true;
+        pending->sent = true;
     }
 
-    /* the handler will free() the reply unless it returns false */
-    if (!handler->cb(NULL, conn, state, window, atom, propr))
-        FREE(propr);
+    /* Deletions do not wait for a reply, so unless a request is in front of
+     * them, they can be handled right away. */
+    if (deleted)
+        handle_property_replies();
+}
+
+/*
+ * Fetches and handles all pending properties, waiting for the replies. Used
+ * by the i3 sync protocol, which promises the client that everything it did
+ * before was handled.
+ *
+ */
+static void sync_pending_properties(void) {
+    struct pending_property *pending;
+
+    handle_pending_properties();
+    while ((pending = TAILQ_FIRST(&pending_properties)) != NULL) {
+        xcb_get_property_reply_t *propr = NULL;
+        if (pending->state != XCB_PROPERTY_DELETE)
+            propr = xcb_get_property_reply(conn, pending->cookie, NULL);
+
+        TAILQ_REMOVE(&pending_properties, pending, pending_properties);
+
+        /* the handler will free() the reply unless it returns false */
+        if (!pending->handler->cb(NULL, conn, pending->state, pending->window, pending->atom, propr))
+            FREE(propr);
+        free(pending);
+    }
 }
 
 /*
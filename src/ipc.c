@@ -13,6 +13,7 @@
 #include "yajl_utils.h"
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <fcntl.h>
 #include <libgen.h>
@@ -24,6 +25,42 @@ char *current_socketpath = NULL;
 
 TAILQ_HEAD(ipc_client_head, ipc_client) all_clients = TAILQ_HEAD_INITIALIZER(all_clients);
 
+/* Names of the events clients can subscribe to, indexed by event number
+ * (message type without I3_IPC_EVENT_MASK). */
+static const char *event_names[I3_IPC_EVENT_COUNT] = {
+    "workspace",
+    "output",
+    "mode",
+    "window",
+    "barconfig_update",
+    "binding",
+    "tree",
+};
+
+/* Number of clients subscribed to each event. */
+static int event_subscribers[I3_IPC_EVENT_COUNT];
+
+/*
+ * Returns the bit of the given event type in ipc_client->events.
+ *
+ */
+static uint32_t event_bit(uint32_t message_type) {
+    const uint32_t event = message_type & ~I3_IPC_EVENT_MASK;
+    assert(event < I3_IPC_EVENT_COUNT);
+    return (1 << event);
+}
+
+/*
+ * Removes all subscriptions of the given client.
+ *
+ */
+static void ipc_unsubscribe_all(ipc_client *client) {
+    for (int event = 0; event < I3_IPC_EVENT_COUNT; event++)
+        if (client->events & (1 << event))
+            event_subscribers[event]--;
+    client->events = 0;
+}
+
 /*
  * Puts the given socket file descriptor into non-blocking mode or dies if
  * setting O_NONBLOCK failed. Non-blocking sockets are a good idea for our
@@ -37,42 +74,246 @@ static void set_nonblock(int sockfd) {
         err(-1, "Could not set O_NONBLOCK");
 }
 
+/* Size of the output buffer of a client once output has to be queued for the
+ * first time. The buffer is doubled as needed, up to ipc_buffer_limit. */
+#define IPC_BUFFER_INITIAL_SIZE 4096
+
+static void ipc_socket_writeable_cb(EV_P_ struct ev_io *w, int revents);
+
+static size_t size_min(size_t a, size_t b) {
+    return (a < b ? a : b);
+}
+
+/*
+ * Shuts down the connection to a client which does not read its output or
+ * whose socket failed. The client is not freed here because we might be in
+ * the middle of handling one of its requests. Instead, the read watcher will
+ * notice the closed connection and free it.
+ *
+ */
+static void ipc_drop_client(ipc_client *client) {
+    client->dropped = true;
+    ipc_unsubscribe_all(client);
+    ev_io_stop(main_loop, client->write_callback);
+    FREE(client->buffer);
+    client->buffer_size = 0;
+    client->buffer_start = 0;
+    client->buffer_len = 0;
+    shutdown(client->fd, SHUT_RDWR);
+}
+
+/*
+ * Appends the given data to the output ring buffer of the client, growing
+ * the buffer if necessary. The caller has to ensure that ipc_buffer_limit is
+ * not exceeded.
+ *
+ */
+static void ipc_buffer_append(ipc_client *client, const uint8_t *data, size_t len) {
+    if (len == 0)
+        return;
+
+    const size_t needed = client->buffer_len + len;
+    if (needed > client->buffer_size) {
+        size_t new_size = (client->buffer_size == 0 ? IPC_BUFFER_INITIAL_SIZE : client->buffer_size);
+        while (new_size < needed)
+            new_size *= 2;
+        if (new_size > config.ipc_buffer_limit)
+            new_size = needed;
+
+        /* Copy the queued data to the beginning of the new buffer, so that it
+         * does not wrap around anymore. */
+        uint8_t *new_buffer = smalloc(new_size);
+        if (client->buffer_len > 0) {
+            const size_t first = size_min(client->buffer_len, client->buffer_size - client->buffer_start);
+            memcpy(new_buffer, client->buffer + client->buffer_start, first);
+            memcpy(new_buffer + first, client->buffer, client->buffer_len - first);
+        }
+        free(client->buffer);
+        client->buffer = new_buffer;
+        client->buffer_size = new_size;
+        client->buffer_start = 0;
+    }
+
+    const size_t end = (client->buffer_start + client->buffer_len) % client->buffer_size;
+    const size_t first = size_min(len, client->buffer_size - end);
+    memcpy(client->buffer + end, data, first);
+    memcpy(client->buffer, data + first, len - first);
+    client->buffer_len += len;
+}
+
+/*
+ * Writes as much of the queued output of the client as its socket accepts
+ * without blocking. If output remains, the write watcher is started, which
+ * calls this function again as soon as the socket is writeable.
+ *
+ */
+static void ipc_push_pending(ipc_client *client) {
+    while (client->buffer_len > 0) {
+        const size_t chunk = size_min(client->buffer_len, client->buffer_size - client->buffer_start);
+        const ssize_t n = write(client->fd, client->buffer + client->buffer_start, chunk);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+
+            ELOG("IPC: could not write to client on fd %d: %s, disconnecting\n",
+                 client->fd, strerror(errno));
+            ipc_drop_client(client);
+            return;
+        }
+
+        client->buffer_start = (client->buffer_start + n) % client->buffer_size;
+        client->buffer_len -= n;
+    }
+
+    if (client->buffer_len == 0) {
+        client->buffer_start = 0;
+        ev_io_stop(main_loop, client->write_callback);
+    } else if (!ev_is_active(client->write_callback)) {
+        ev_io_start(main_loop, client->write_callback);
+    }
+}
+
+/*
+ * Sends a message (payload) of the given size and type to the client. As much
+ * of it as possible is written without blocking, the rest is queued. Clients
+ * which have more than ipc_buffer_limit bytes of queued output are
+ * disconnected, so a single message bigger than the limit is fine as long as
+ * the client reads it.
+ *
+ */
+static void ipc_send_client_message(ipc_client *client, size_t size,
+                                    const uint32_t message_type, const uint8_t *payload) {
+    if (client->dropped)
+        return;
+
+    const i3_ipc_header_t header = {
+        /* We don’t use I3_IPC_MAGIC because it’s a 0-terminated C string. */
+        .magic = {'i', '3', '-', 'i', 'p', 'c'},
+        .size = size,
+        .type = message_type};
+
+    /* Unless older output is still queued (which has to be sent first), try
+     * to write the message right away. Only the part the socket does not
+     * accept counts against ipc_buffer_limit. */
+    size_t sent = 0;
+    if (client->buffer_len == 0) {
+        struct iovec iov[2] = {
+            {.iov_base = (void *)&header, .iov_len = sizeof(i3_ipc_header_t)},
+            {.iov_base = (void *)payload, .iov_len = size}};
+        ssize_t n;
+        do {
+            n = writev(client->fd, iov, 2);
+        } while (n == -1 && errno == EINTR);
+
+        if (n == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ELOG("IPC: could not write to client on fd %d: %s, disconnecting\n",
+                     client->fd, strerror(errno));
+                ipc_drop_client(client);
+                return;
+            }
+        } else {
+            sent = n;
+        }
+    }
+
+    const size_t header_sent = size_min(sent, sizeof(i3_ipc_header_t));
+    const size_t payload_sent = sent - header_sent;
+    const size_t remaining = sizeof(i3_ipc_header_t) + size - sent;
+    if (remaining == 0)
+        return;
+
+    if (client->buffer_len + remaining > config.ipc_buffer_limit) {
+        ELOG("IPC: client on fd %d has more than %zu bytes of unread output, disconnecting\n",
+             client->fd, config.ipc_buffer_limit);
+        ipc_drop_client(client);
+        return;
+    }
+
+    ipc_buffer_append(client, (const uint8_t *)&header + header_sent, sizeof(i3_ipc_header_t) - header_sent);
+    ipc_buffer_append(client, payload + payload_sent, size - payload_sent);
+    ipc_push_pending(client);
+}
+
+/*
+ * Called by libev when the socket of a client with queued output becomes
+ * writeable.
+ *
+ */
+static void ipc_socket_writeable_cb(EV_P_ struct ev_io *w, int revents) {
+    ipc_push_pending((ipc_client *)w->data);
+}
+
+/*
+ * Closes the connection to the client and frees all of its resources.
+ *
+ */
+static void free_ipc_client(ipc_client *client) {
+    close(client->fd);
+
+    ev_io_stop(main_loop, client->read_callback);
+    FREE(client->read_callback);
+    ev_io_stop(main_loop, client->write_callback);
+    FREE(client->write_callback);
+
+    ipc_unsubscribe_all(client);
+    FREE(client->buffer);
+
+    TAILQ_REMOVE(&all_clients, client, clients);
+    free(client);
+}
+
 /*
  * Sends the specified event to all IPC clients which are currently connected
  * and subscribed to this kind of event.
  *
  */
 void ipc_send_event(const char *event, uint32_t message_type, const char *payload) {
+    if (!ipc_has_event_subscribers(message_type))
+        return;
+
+    const uint32_t bit = event_bit(message_type);
     ipc_client *current;
     TAILQ_FOREACH(current, &all_clients, clients) {
         /* see if this client is interested in this event */
-        bool interested = false;
-        for (int i = 0; i < current->num_events; i++) {
-            if (strcasecmp(current->events[i], event) != 0)
-                continue;
-            interested = true;
-            break;
-        }
-        if (!interested)
+        if (!(current->events & bit))
             continue;
 
-        ipc_send_message(current->fd, strlen(payload), message_type, (const uint8_t *)payload);
+        ipc_send_client_message(current, strlen(payload), message_type, (const uint8_t *)payload);
     }
 }
 
+/*
+ * Returns true if at least one IPC client is subscribed to the given event
+ * type (one of the I3_IPC_EVENT_* constants). Callers use this to avoid
+ * generating the payload of events nobody is interested in.
+ *
+ */
+bool ipc_has_event_subscribers(uint32_t message_type) {
+    return (event_subscribers[message_type & ~I3_IPC_EVENT_MASK] > 0);
+}
+
 /*
  * Calls shutdown() on each socket and closes it. This function to be called
  * when exiting or restarting only!
  *
+ * Since this is called from within the 'exit' and 'restart' commands, the
+ * clients are not freed: the client which sent the command is still being
+ * handled. Output which is still queued is flushed as far as possible
+ * without blocking.
+ *
  */
 void ipc_shutdown(void) {
     ipc_client *current;
-    while (!TAILQ_EMPTY(&all_clients)) {
-        current = TAILQ_FIRST(&all_clients);
-        shutdown(current->fd, SHUT_RDWR);
+    TAILQ_FOREACH(current, &all_clients, clients) {
+        if (current->dropped)
+            continue;
+        ipc_push_pending(current);
+        ipc_drop_client(current);
+        ev_io_stop(main_loop, current->read_callback);
         close(current->fd);
-        TAILQ_REMOVE(&all_clients, current, clients);
-        free(current);
     }
 }
 
@@ -101,8 +342,8 @@ IPC_HANDLER(command) {
     ylength length;
     yajl_gen_get_buf(gen, &reply, &length);
 
-    ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_COMMAND,
-                     (const uint8_t *)reply);
+    ipc_send_client_message(client, length, I3_IPC_REPLY_TYPE_COMMAND,
+                            (const uint8_t *)reply);
 
     yajl_gen_free(gen);
 }
@@ -190,6 +431,12 @@ void dump_node(yajl_gen gen, struct Con *con, bool inplace_restart) {
     ystr("id");
     y(integer, (long int)con);
 
+    if (con->type == CT_ROOT && !inplace_restart) {
+        /* The number of "tree" events which are reflected in this tree. */
+        ystr("generation");
+        y(integer, tree_generation);
+    }
+
     ystr("type");
     switch (con->type) {
         case CT_ROOT:
@@ -665,7 +912,7 @@ IPC_HANDLER(tree) {
     ylength length;
     y(get_buf, &payload, &length);
 
-    ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_TREE, payload);
+    ipc_send_client_message(client, length, I3_IPC_REPLY_TYPE_TREE, payload);
     y(free);
 }
 
@@ -729,7 +976,7 @@ IPC_HANDLER(get_workspaces) {
     ylength length;
     y(get_buf, &payload, &length);
 
-    ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_WORKSPACES, payload);
+    ipc_send_client_message(client, length, I3_IPC_REPLY_TYPE_WORKSPACES, payload);
     y(free);
 }
 
@@ -783,7 +1030,7 @@ IPC_HANDLER(get_outputs) {
     ylength length;
     y(get_buf, &payload, &length);
 
-    ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_OUTPUTS, payload);
+    ipc_send_client_message(client, length, I3_IPC_REPLY_TYPE_OUTPUTS, payload);
     y(free);
 }
 
@@ -797,9 +1044,8 @@ IPC_HANDLER(get_marks) {
     y(array_open);
 
     Con *con;
-    TAILQ_FOREACH(con, &all_cons, all_cons)
-    if (con->mark != NULL)
-        ystr(con->mark);
+    TAILQ_FOREACH(con, &marked_cons, marked_cons)
+    ystr(con->mark);
 
     y(array_close);
 
@@ -807,7 +1053,7 @@ IPC_HANDLER(get_marks) {
     ylength length;
     y(get_buf, &payload, &length);
 
-    ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_MARKS, payload);
+    ipc_send_client_message(client, length, I3_IPC_REPLY_TYPE_MARKS, payload);
     y(free);
 }
 
@@ -840,7 +1086,34 @@ IPC_HANDLER(get_version) {
     ylength length;
     y(get_buf, &payload, &length);
 
-    ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_VERSION, payload);
+    ipc_send_client_message(client, length, I3_IPC_REPLY_TYPE_VERSION, payload);
+    y(free);
+}
+
+/*
+ * Returns statistics about the last call of tree_render()
+ *
+ */
+IPC_HANDLER(get_render_stats) {
+    yajl_gen gen = ygenalloc();
+    y(map_open);
+
+    ystr("frames");
+    y(integer, render_stats.frames);
+
+    ystr("rendered");
+    y(integer, render_stats.rendered);
+
+    ystr("gaps_recomputed");
+    y(integer, render_stats.gaps_recomputed);
+
+    y(map_close);
+
+    const unsigned char *payload;
+    ylength length;
+    y(get_buf, &payload, &length);
+
+    ipc_send_client_message(client, length, I3_IPC_REPLY_TYPE_RENDER_STATS, payload);
     y(free);
 }
 
@@ -865,7 +1138,7 @@ IPC_HANDLER(get_bar_config) {
         ylength length;
         y(get_buf, &payload, &length);
 
-        ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_BAR_CONFIG, payload);
+        ipc_send_client_message(client, length, I3_IPC_REPLY_TYPE_BAR_CONFIG, payload);
         y(free);
         return;
     }
@@ -901,7 +1174,7 @@ IPC_HANDLER(get_bar_config) {
     ylength length;
     y(get_buf, &payload, &length);
 
-    ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_BAR_CONFIG, payload);
+    ipc_send_client_message(client, length, I3_IPC_REPLY_TYPE_BAR_CONFIG, payload);
     y(free);
 }
 
@@ -914,20 +1187,23 @@ static int add_subscription(void *extra, const unsigned char *s,
     ipc_client *client = extra;
 
     DLOG("should add subscription to extra %p, sub %.*s\n", client, (int)len, s);
-    int event = client->num_events;
+    for (int event = 0; event < I3_IPC_EVENT_COUNT; event++) {
+        if (strlen(event_names[event]) != len ||
+            strncasecmp(event_names[event], (const char *)s, len) != 0)
+            continue;
 
-    client->num_events++;
-    client->events = realloc(client->events, client->num_events * sizeof(char *));
-    /* We copy the string because it is not null-terminated and strndup()
-     * is missing on some BSD systems */
-    client->events[event] = scalloc(len + 1);
-    memcpy(client->events[event], s, len);
+        if (!(client->events & (1 << event))) {
+            client->events |= (1 << event);
+            event_subscribers[event]++;
 
-    DLOG("client is now subscribed to:\n");
-    for (int i = 0; i < client->num_events; i++)
-        DLOG("event %s\n", client->events[i]);
-    DLOG("(done)\n");
+            if (event == (I3_IPC_EVENT_TREE & ~I3_IPC_EVENT_MASK))
+                tree_diff_start();
+        }
+        DLOG("client is now subscribed to events 0x%08x\n", client->events);
+        return 1;
+    }
 
+    ELOG("Client tried to subscribe to unknown event %.*s\n", (int)len, s);
     return 1;
 }
 
@@ -939,21 +1215,6 @@ static int add_subscription(void *extra, const unsigned char *s,
 IPC_HANDLER(subscribe) {
     yajl_handle p;
     yajl_status stat;
-    ipc_client *current, *client = NULL;
-
-    /* Search the ipc_client structure for this connection */
-    TAILQ_FOREACH(current, &all_clients, clients) {
-        if (current->fd != fd)
-            continue;
-
-        client = current;
-        break;
-    }
-
-    if (client == NULL) {
-        ELOG("Could not find ipc_client data structure for fd %d\n", fd);
-        return;
-    }
 
     /* Setup the JSON parser */
     static yajl_callbacks callbacks = {
@@ -970,18 +1231,271 @@ IPC_HANDLER(subscribe) {
         yajl_free_error(p, err);
 
         const char *reply = "{\"success\":false}";
-        ipc_send_message(fd, strlen(reply), I3_IPC_REPLY_TYPE_SUBSCRIBE, (const uint8_t *)reply);
+        ipc_send_client_message(client, strlen(reply), I3_IPC_REPLY_TYPE_SUBSCRIBE, (const uint8_t *)reply);
         yajl_free(p);
         return;
     }
     yajl_free(p);
     const char *reply = "{\"success\":true}";
-    ipc_send_message(fd, strlen(reply), I3_IPC_REPLY_TYPE_SUBSCRIBE, (const uint8_t *)reply);
+    ipc_send_client_message(client, strlen(reply), I3_IPC_REPLY_TYPE_SUBSCRIBE, (const uint8_t *)reply);
+}
+
+/* The command strings of a RUN_COMMANDS message. */
+struct command_list {
+    char **commands;
+    int num;
+    /* Nesting level of arrays at the current position of the parser. */
+    int depth;
+    /* Whether the top-level array was seen already. */
+    bool seen_array;
+};
+
+/*
+ * Callback for the YAJL parser (will be called when an array starts). Only a
+ * single, top-level array is accepted.
+ *
+ */
+static int command_list_start_array(void *extra) {
+    struct command_list *list = extra;
+
+    if (list->depth > 0 || list->seen_array)
+        return 0;
+    list->depth++;
+    list->seen_array = true;
+    return 1;
+}
+
+/*
+ * Callback for the YAJL parser (will be called when an array ends).
+ *
+ */
+static int command_list_end_array(void *extra) {
+    struct command_list *list = extra;
+
+    list->depth--;
+    return 1;
+}
+
+/*
+ * Callback for the YAJL parser, used for maps, numbers, booleans and null,
+ * which are not valid in a RUN_COMMANDS payload. Aborts parsing.
+ *
+ */
+static int command_list_reject(void *extra) {
+    return 0;
+}
+
+static int command_list_reject_number(void *extra, const char *s, ylength len) {
+    return 0;
+}
+
+static int command_list_reject_boolean(void *extra, int val) {
+    return 0;
+}
+
+/*
+ * Callback for the YAJL parser (will be called when a string is parsed).
+ * Strings are only accepted as elements of the top-level array.
+ *
+ */
+static int add_command(void *extra, const unsigned char *s, ylength len) {
+    struct command_list *list = extra;
+
+    if (list->depth != 1)
+        return 0;
+
+    list->commands = srealloc(list->commands, (list->num + 1) * sizeof(char *));
+    list->commands[list->num++] = sstrndup((const char *)s, len);
+    return 1;
+}
+
+/*
+ * Executes the commands given as a JSON serialized array of command strings
+ * in the payload, one after the other. Unlike sending each of them in a
+ * COMMAND message, the tree is rendered (and the changes are pushed to X11)
+ * only once, after the last command. The reply contains the results of each
+ * command string, in order.
+ *
+ */
+IPC_HANDLER(run_commands) {
+    struct command_list list = {NULL, 0, 0, false};
+
+    static yajl_callbacks callbacks = {
+        .yajl_null = command_list_reject,
+        .yajl_boolean = command_list_reject_boolean,
+        .yajl_number = command_list_reject_number,
+        .yajl_string = add_command,
+        .yajl_start_map = command_list_reject,
+        .yajl_start_array = command_list_start_array,
+        .yajl_end_array = command_list_end_array,
+    };
+
+    /* The whole payload is parsed (and validated) before the first command
+     * runs, so that an invalid payload does not get executed partially. */
+    yajl_handle p = yalloc(&callbacks, (void *)&list);
+    yajl_status stat = yajl_parse(p, (const unsigned char *)message, message_size);
+    if (stat == yajl_status_ok)
+        stat = yajl_complete_parse(p);
+    if (stat != yajl_status_ok || !list.seen_array) {
+        if (stat != yajl_status_ok) {
+            unsigned char *err;
+            err = yajl_get_error(p, true, (const unsigned char *)message,
+                                 message_size);
+            ELOG("YAJL parse error: %s\n", err);
+            yajl_free_error(p, err);
+        } else {
+            ELOG("RUN_COMMANDS payload is not an array\n");
+        }
+
+        const char *reply = "{\"success\":false,\"error\":\"Could not parse the payload as a JSON array of commands\"}";
+        ipc_send_client_message(client, strlen(reply), I3_IPC_REPLY_TYPE_RUN_COMMANDS, (const uint8_t *)reply);
+        yajl_free(p);
+        for (int i = 0; i < list.num; i++)
+            free(list.commands[i]);
+        free(list.commands);
+        return;
+    }
+    yajl_free(p);
+
+    yajl_gen gen = ygenalloc();
+    bool needs_tree_render = false;
+
+    y(array_open);
+    for (int i = 0; i < list.num; i++) {
+        LOG("IPC: received (%d/%d): *%s*\n", i + 1, list.num, list.commands[i]);
+        CommandResult *result = parse_command(list.commands[i], gen);
+        needs_tree_render |= result->needs_tree_render;
+        command_result_free(result);
+        free(list.commands[i]);
+    }
+    y(array_close);
+    free(list.commands);
+
+    if (needs_tree_render)
+        tree_render();
+
+    const unsigned char *reply;
+    ylength length;
+    y(get_buf, &reply, &length);
+
+    ipc_send_client_message(client, length, I3_IPC_REPLY_TYPE_RUN_COMMANDS,
+                            (const uint8_t *)reply);
+
+    y(free);
+}
+
+/* Number of buckets of the GET_X_STATS histogram. Bucket 0 counts renders
+ * without requests, bucket n > 0 those with 2^(n-1) to 2^n - 1 requests. The
+ * last bucket is open-ended. */
+#define X_STATS_BUCKETS 12
+
+static void dump_request_counts(yajl_gen gen, const uint64_t counts[XR_NUM_TYPES]) {
+    y(map_open);
+    for (int type = 0; type < XR_NUM_TYPES; type++) {
+        ystr(x_request_name(type));
+        y(integer, counts[type]);
+    }
+    y(map_close);
+}
+
+/*
+ * Returns how many X11 requests i3 sent during the last renders, see
+ * x_request_stats.
+ *
+ */
+IPC_HANDLER(get_x_stats) {
+    const struct x_request_stats *stats = &x_request_stats;
+    yajl_gen gen = ygenalloc();
+    y(map_open);
+
+    ystr("renders");
+    y(integer, stats->renders);
+
+    ystr("last");
+    y(map_open);
+    uint64_t last[XR_NUM_TYPES];
+    for (int type = 0; type < XR_NUM_TYPES; type++)
+        last[type] = stats->last[type];
+    ystr("requests");
+    dump_request_counts(gen, last);
+    ystr("duration_ms");
+    y(double, stats->last_duration * 1000);
+    ystr("heaviest_container");
+    if (stats->heaviest == NULL)
+        y(null);
+    else
+        y(integer, (long int)stats->heaviest);
+    ystr("heaviest_requests");
+    y(integer, stats->heaviest_requests);
+    y(map_close);
+
+    ystr("total");
+    dump_request_counts(gen, stats->total);
+
+    uint32_t buckets[X_STATS_BUCKETS] = {0};
+    double max_duration = 0, sum_duration = 0;
+    const int samples = (stats->renders < X_REQUEST_HISTORY ? stats->renders : X_REQUEST_HISTORY);
+    for (int i = 0; i < samples; i++) {
+        uint32_t requests = stats->history[i].requests;
+        int bucket = 0;
+        while (requests > 0 && bucket < X_STATS_BUCKETS - 1) {
+            requests >>= 1;
+            bucket++;
+        }
+        buckets[bucket]++;
+        if (stats->history[i].duration > max_duration)
+            max_duration = stats->history[i].duration;
+        sum_duration += stats->history[i].duration;
+    }
+
+    ystr("samples");
+    y(integer, samples);
+
+    ystr("histogram");
+    y(array_open);
+    for (int bucket = 0; bucket < X_STATS_BUCKETS; bucket++) {
+        y(map_open);
+        ystr("min");
+        y(integer, (bucket == 0 ? 0 : 1 << (bucket - 1)));
+        ystr("max");
+        if (bucket == X_STATS_BUCKETS - 1)
+            y(null);
+        else
+            y(integer, (1 << bucket) - 1);
+        ystr("renders");
+        y(integer, buckets[bucket]);
+        y(map_close);
+    }
+    y(array_close);
+
+    ystr("max_duration_ms");
+    y(double, max_duration * 1000);
+    ystr("average_duration_ms");
+    y(double, (samples == 0 ? 0 : sum_duration * 1000 / samples));
+
+    uint64_t hits, misses;
+    text_width_cache_stats(&hits, &misses);
+    ystr("text_width_cache");
+    y(map_open);
+    ystr("hits");
+    y(integer, hits);
+    ystr("misses");
+    y(integer, misses);
+    y(map_close);
+
+    y(map_close);
+
+    const unsigned char *payload;
+    ylength length;
+    y(get_buf, &payload, &length);
+
+    ipc_send_client_message(client, length, I3_IPC_REPLY_TYPE_X_STATS, payload);
+    y(free);
 }
 
 /* The index of each callback function corresponds to the numeric
  * value of the message type (see include/i3/ipc.h) */
-handler_t handlers[8] = {
+handler_t handlers[11] = {
     handle_command,
     handle_get_workspaces,
     handle_subscribe,
@@ -990,6 +1504,9 @@ handler_t handlers[8] = {
     handle_get_marks,
     handle_get_bar_config,
     handle_get_version,
+    handle_get_render_stats,
+    handle_run_commands,
+    handle_get_x_stats,
 };
 
 /*
@@ -1003,6 +1520,7 @@ handler_t handlers[8] = {
  *
  */
 static void ipc_receive_message(EV_P_ struct ev_io *w, int revents) {
+    ipc_client *client = (ipc_client *)w->data;
     uint32_t message_type;
     uint32_t message_length;
     uint8_t *message = NULL;
@@ -1017,26 +1535,8 @@ static void ipc_receive_message(EV_P_ struct ev_io *w, int revents) {
         }
 
         /* If not, there was some kind of error. We don’t bother
-         * and close the connection */
-        close(w->fd);
-
-        /* Delete the client from the list of clients */
-        ipc_client *current;
-        TAILQ_FOREACH(current, &all_clients, clients) {
-            if (current->fd != w->fd)
-                continue;
-
-            for (int i = 0; i < current->num_events; i++)
-                free(current->events[i]);
-            /* We can call TAILQ_REMOVE because we break out of the
-             * TAILQ_FOREACH afterwards */
-            TAILQ_REMOVE(&all_clients, current, clients);
-            free(current);
-            break;
-        }
-
-        ev_io_stop(EV_A_ w);
-        free(w);
+         * and close the connection. This also frees w. */
+        free_ipc_client(client);
         FREE(message);
 
         DLOG("IPC: client disconnected\n");
@@ -1047,7 +1547,7 @@ static void ipc_receive_message(EV_P_ struct ev_io *w, int revents) {
         DLOG("Unhandled message type: %d\n", message_type);
     else {
         handler_t h = handlers[message_type];
-        h(w->fd, message, 0, message_length, message_type);
+        h(client, message, 0, message_length, message_type);
     }
 
     FREE(message);
@@ -1077,15 +1577,21 @@ void ipc_new_client(EV_P_ struct ev_io *w, int revents) {
 
     set_nonblock(client);
 
-    struct ev_io *package = scalloc(sizeof(struct ev_io));
-    ev_io_init(package, ipc_receive_message, client, EV_READ);
-    ev_io_start(EV_A_ package);
-
-    DLOG("IPC: new client connected on fd %d\n", w->fd);
-
     ipc_client *new = scalloc(sizeof(ipc_client));
     new->fd = client;
 
+    new->read_callback = scalloc(sizeof(struct ev_io));
+    new->read_callback->data = new;
+    ev_io_init(new->read_callback, ipc_receive_message, client, EV_READ);
+    ev_io_start(EV_A_ new->read_callback);
+
+    /* Started by ipc_push_pending() when output has to be queued. */
+    new->write_callback = scalloc(sizeof(struct ev_io));
+    new->write_callback->data = new;
+    ev_io_init(new->write_callback, ipc_socket_writeable_cb, client, EV_WRITE);
+
+    DLOG("IPC: new client connected on fd %d\n", w->fd);
+
     TAILQ_INSERT_TAIL(&all_clients, new, clients);
 }
 
@@ -1178,6 +1684,9 @@ yajl_gen ipc_marshal_workspace_event(const char *change, Con *current, Con *old)
  * previously focused workspace in "old".
  */
 void ipc_send_workspace_event(const char *change, Con *current, Con *old) {
+    if (!ipc_has_event_subscribers(I3_IPC_EVENT_WORKSPACE))
+        return;
+
     yajl_gen gen = ipc_marshal_workspace_event(change, current, old);
 
     const unsigned char *payload;
@@ -1194,6 +1703,9 @@ void ipc_send_workspace_event(const char *change, Con *current, Con *old) {
  * also the window container, in "container".
  */
 void ipc_send_window_event(const char *property, Con *con) {
+    if (!ipc_has_event_subscribers(I3_IPC_EVENT_WINDOW))
+        return;
+
     DLOG("Issue IPC window %s event (con = %p, window = 0x%08x)\n",
          property, con, (con->window ? con->window->id : XCB_WINDOW_NONE));
 
@@ -1223,6 +1735,9 @@ void ipc_send_window_event(const char *property, Con *con) {
  * For the barconfig update events, we send the serialized barconfig.
  */
 void ipc_send_barconfig_update_event(Barconfig *barconfig) {
+    if (!ipc_has_event_subscribers(I3_IPC_EVENT_BARCONFIG_UPDATE))
+        return;
+
     DLOG("Issue barconfig_update event for id = %s\n", barconfig->id);
     setlocale(LC_NUMERIC, "C");
     yajl_gen gen = ygenalloc();
@@ -1242,6 +1757,9 @@ void ipc_send_barconfig_update_event(Barconfig *barconfig) {
  * For the binding events, we send the serialized binding struct.
  */
 void ipc_send_binding_event(const char *event_type, Binding *bind) {
+    if (!ipc_has_event_subscribers(I3_IPC_EVENT_BINDING))
+        return;
+
     DLOG("Issue IPC binding %s event (sym = %s, code = %d)\n", event_type, bind->symbol, bind->keycode);
 
     setlocale(LC_NUMERIC, "C");
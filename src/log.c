@@ -15,6 +15,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -34,6 +35,8 @@
 
 static bool debug_logging = false;
 static bool verbose = false;
+bool verboselog_enabled = false;
+bool debuglog_enabled = false;
 static FILE *errorfile;
 char *errorfilename;
 
@@ -47,27 +50,45 @@ char *shmlogname = "";
 int shmlog_size = 0;
 /* If enabled, logbuffer will point to a memory mapping of the i3 SHM log. */
 static char *logbuffer;
-/* A pointer (within logbuffer) where data will be written to next. */
-static char *logwalk;
 /* A pointer to the shmlog header */
 static i3_shmlog_header *header;
-/* A pointer to the byte where we last wrapped. Necessary to not print the
- * left-overs at the end of the ringbuffer. */
-static char *loglastwrap;
+/* The ringbuffer (within logbuffer) which text lines or binary records are
+ * written to, and its size. */
+static char *logring;
+static uint64_t logring_capacity;
 /* Size (in bytes) of the i3 SHM log. */
 static int logbuffer_size;
 /* File descriptor for shm_open. */
 static int logbuffer_shm;
 
+/* If true, the SHM log is a ring of binary records (see shmlog.h) instead of
+ * formatted text lines. Set with --shmlog-binary. */
+static bool shmlog_binary = false;
+
+/* Maximum length of the formatted message of a log call. Longer messages are
+ * truncated (text log) or cut off (binary log). */
+#define MAX_MESSAGE_LEN 4096
+
+/*
+ * Updates verboselog_enabled and debuglog_enabled, which LOG() and DLOG()
+ * check before evaluating their arguments. Messages are saved in the SHM log
+ * even when they are not printed.
+ *
+ */
+static void update_log_enabled(void) {
+    verboselog_enabled = (logbuffer != NULL || verbose);
+    debuglog_enabled = (logbuffer != NULL || debug_logging);
+}
+
 /*
  * Writes the offsets for the next write and for the last wrap to the
- * shmlog_header.
- * Necessary to print the i3 SHM log in the correct order.
+ * shmlog_header. These are only kept for readers which do not use the
+ * absolute offsets (head) yet.
  *
  */
 static void store_log_markers(void) {
-    header->offset_next_write = (logwalk - logbuffer);
-    header->offset_last_wrap = (loglastwrap - logbuffer);
+    header->offset_next_write = I3_SHMLOG_DATA_OFFSET + (header->head % logring_capacity);
+    header->offset_last_wrap = I3_SHMLOG_DATA_OFFSET + logring_capacity;
     header->size = logbuffer_size;
 }
 
@@ -160,9 +181,23 @@ void open_logbuffer(void) {
         fprintf(stderr, "pthread_condattr_setpshared() failed, i3-dump-log -f will not work!\n");
     pthread_cond_init(&(header->condvar), &cond_attr);
 
-    logwalk = logbuffer + sizeof(i3_shmlog_header);
-    loglastwrap = logbuffer + logbuffer_size;
+    header->size = logbuffer_size;
+    logring = logbuffer + I3_SHMLOG_DATA_OFFSET;
+    logring_capacity = i3_shmlog_capacity(header);
     store_log_markers();
+
+    if (shmlog_binary) {
+        struct timespec mono, real;
+        clock_gettime(CLOCK_MONOTONIC, &mono);
+        clock_gettime(CLOCK_REALTIME, &real);
+        header->realtime_offset = (int64_t)(real.tv_sec - mono.tv_sec) * 1000000000 +
+                                  (real.tv_nsec - mono.tv_nsec);
+        /* Published last: readers decide based on the format which fields
+         * they look at. */
+        __atomic_store_n(&(header->format), I3_SHMLOG_FORMAT_BINARY, __ATOMIC_RELEASE);
+    }
+
+    update_log_enabled();
 }
 
 /*
@@ -174,6 +209,23 @@ void close_logbuffer(void) {
     shm_unlink(shmlogname);
     logbuffer = NULL;
     shmlogname = "";
+    update_log_enabled();
+}
+
+/*
+ * Switches the SHM log between text lines and binary records. If the SHM log
+ * is already open, it is re-opened in the new format.
+ *
+ */
+void set_shmlog_binary(bool binary) {
+    if (shmlog_binary == binary)
+        return;
+
+    shmlog_binary = binary;
+    if (logbuffer) {
+        close_logbuffer();
+        open_logbuffer();
+    }
 }
 
 /*
@@ -184,6 +236,7 @@ void close_logbuffer(void) {
  */
 void set_verbosity(bool _verbose) {
     verbose = _verbose;
+    update_log_enabled();
 }
 
 /*
@@ -200,24 +253,145 @@ bool get_debug_logging(void) {
  */
 void set_debug_logging(const bool _debug_logging) {
     debug_logging = _debug_logging;
+    update_log_enabled();
+}
+
+/*
+ * Appends a formatted message to the text SHM log. Messages which do not fit
+ * at the end of the ringbuffer are continued at its beginning, so that the
+ * position of each byte is its absolute offset modulo the capacity.
+ *
+ */
+static void textlog_append(const char *message, size_t len) {
+    if (len > logring_capacity)
+        len = logring_capacity;
+
+    const uint64_t head = header->head;
+    __atomic_store_n(&(header->reserved), head + len, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    const uint64_t pos = head % logring_capacity;
+    const size_t first = min(len, logring_capacity - pos);
+    memcpy(logring + pos, message, first);
+    if (first < len) {
+        memcpy(logring, message + first, len - first);
+        header->wrap_count++;
+    }
+
+    __atomic_store_n(&(header->head), head + len, __ATOMIC_RELEASE);
+    store_log_markers();
+}
+
+/*
+ * Appends a record to the binary SHM log. Only the message itself is
+ * formatted here, the timestamp and the source location are stored as-is and
+ * formatted by i3-dump-log.
+ *
+ * Readers do not take any lock, see i3_shmlog_header for how they detect
+ * records which were overwritten while they read them.
+ *
+ */
+static void binlog_append(const uint16_t level, const char *file, const char *function,
+                          const int line, const char *fmt, va_list args) {
+    const size_t file_len = (file ? min(strlen(file), UINT16_MAX) : 0);
+    const size_t function_len = (function ? min(strlen(function), UINT16_MAX) : 0);
+    /* The most this record can take up. vsnprintf() needs one byte for the
+     * terminating NUL which is not part of the record. */
+    const uint64_t max_len = (sizeof(i3_shmlog_record) + file_len + function_len + MAX_MESSAGE_LEN + 1 + 7) & ~7;
+    if (max_len > logring_capacity)
+        return;
+
+    uint64_t head = header->head;
+    uint64_t pos = head % logring_capacity;
+    /* Records are never split at the end of the ring, wrap around by filling
+     * up the rest of it instead. */
+    uint64_t wrap = 0;
+    if (logring_capacity - pos < max_len)
+        wrap = logring_capacity - pos;
+
+    /* Drop the records we are about to overwrite and announce that we are
+     * overwriting them before touching the memory. */
+    const uint64_t end = head + wrap + max_len;
+    uint64_t tail = header->tail;
+    while (tail < head && end - tail > logring_capacity)
+        tail += i3_shmlog_record_length(logring, logring_capacity, tail % logring_capacity);
+    if (end - tail > logring_capacity)
+        tail = head + wrap;
+    __atomic_store_n(&(header->tail), tail, __ATOMIC_RELEASE);
+    __atomic_store_n(&(header->reserved), end, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    if (wrap > 0) {
+        if (wrap >= sizeof(i3_shmlog_record)) {
+            i3_shmlog_record *pad = (i3_shmlog_record *)(logring + pos);
+            memset(pad, 0, sizeof(i3_shmlog_record));
+            pad->length = wrap;
+            pad->level = I3_SHMLOG_LEVEL_PAD;
+        }
+        head += wrap;
+        pos = 0;
+    }
+
+    i3_shmlog_record *record = (i3_shmlog_record *)(logring + pos);
+    char *walk = (char *)(record + 1);
+    if (file_len > 0)
+        memcpy(walk, file, file_len);
+    walk += file_len;
+    if (function_len > 0)
+        memcpy(walk, function, function_len);
+    walk += function_len;
+    int message_len = vsnprintf(walk, MAX_MESSAGE_LEN + 1, fmt, args);
+    if (message_len < 0)
+        message_len = 0;
+    else if (message_len > MAX_MESSAGE_LEN)
+        message_len = MAX_MESSAGE_LEN;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    record->length = (sizeof(i3_shmlog_record) + file_len + function_len + message_len + 7) & ~7;
+    record->line = line;
+    record->seq = header->seq;
+    record->timestamp = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    record->level = level;
+    record->file_len = file_len;
+    record->function_len = function_len;
+    record->message_len = message_len;
+
+    /* Publish the record. */
+    __atomic_store_n(&(header->head), head + record->length, __ATOMIC_RELEASE);
+    __atomic_store_n(&(header->seq), header->seq + 1, __ATOMIC_RELEASE);
 }
 
 /*
  * Logs the given message to stdout (if print is true) while prefixing the
  * current time to it. Additionally, the message will be saved in the i3 SHM
  * log if enabled.
+ * If file is not NULL, the message is prefixed with file:function:line.
  * This is to be called by *LOG() which includes filename/linenumber/function.
  *
  */
-static void vlog(const bool print, const char *fmt, va_list args) {
+static void vlog(const bool print, const uint16_t level, const char *file, const char *function,
+                 const int line, const char *fmt, va_list args) {
     /* Precisely one page to not consume too much memory but to hold enough
      * data to be useful. */
-    static char message[4096];
+    static char message[MAX_MESSAGE_LEN];
     static struct tm result;
     static time_t t;
     static struct tm *tmp;
     static size_t len;
 
+    if (logbuffer && shmlog_binary) {
+        /* The binary log leaves all formatting except for the message itself
+         * to i3-dump-log, so unless we also print, we are done. */
+        va_list copy;
+        va_copy(copy, args);
+        binlog_append(level, file, function, line, fmt, copy);
+        va_end(copy);
+        if (!print)
+            return;
+    }
+
     /* Get current time */
     t = time(NULL);
     /* Convert time to local time (determined by the locale) */
@@ -232,8 +406,10 @@ static void vlog(const bool print, const char *fmt, va_list args) {
      *  true      false  format message, save
      *  false     true   print message only
      *  false     false  INVALID, never called
+     *
+     * In binary mode, the message was already saved above.
      */
-    if (!logbuffer) {
+    if (!logbuffer || shmlog_binary) {
 #ifdef DEBUG_TIMING
         struct timeval tv;
         gettimeofday(&tv, NULL);
@@ -241,28 +417,20 @@ static void vlog(const bool print, const char *fmt, va_list args) {
 #else
         printf("%s", message);
 #endif
+        if (file)
+            printf("%s:%s:%d - ", file, function, line);
         vprintf(fmt, args);
     } else {
-        len += vsnprintf(message + len, sizeof(message) - len, fmt, args);
+        if (file)
+            len += snprintf(message + len, sizeof(message) - len, "%s:%s:%d - ", file, function, line);
+        if (len < sizeof(message))
+            len += vsnprintf(message + len, sizeof(message) - len, fmt, args);
         if (len >= sizeof(message)) {
             fprintf(stderr, "BUG: single log message > 4k\n");
+            len = sizeof(message) - 1;
         }
 
-        /* If there is no space for the current message in the ringbuffer, we
-         * need to wrap and write to the beginning again. */
-        if (len >= (size_t)(logbuffer_size - (logwalk - logbuffer))) {
-            loglastwrap = logwalk;
-            logwalk = logbuffer + sizeof(i3_shmlog_header);
-            store_log_markers();
-            header->wrap_count++;
-        }
-
-        /* Copy the buffer, move the write pointer to the byte after our
-         * current message. */
-        strncpy(logwalk, message, len);
-        logwalk += len;
-
-        store_log_markers();
+        textlog_append(message, len);
 
         /* Wake up all (i3-dump-log) processes waiting for condvar. */
         pthread_cond_broadcast(&(header->condvar));
@@ -284,7 +452,7 @@ void verboselog(char *fmt, ...) {
         return;
 
     va_start(args, fmt);
-    vlog(verbose, fmt, args);
+    vlog(verbose, I3_SHMLOG_LEVEL_VERBOSE, NULL, NULL, 0, fmt, args);
     va_end(args);
 }
 
@@ -296,7 +464,7 @@ void errorlog(char *fmt, ...) {
     va_list args;
 
     va_start(args, fmt);
-    vlog(true, fmt, args);
+    vlog(true, I3_SHMLOG_LEVEL_ERROR, NULL, NULL, 0, fmt, args);
     va_end(args);
 
     /* also log to the error logfile, if opened */
@@ -309,7 +477,7 @@ void errorlog(char *fmt, ...) {
 /*
  * Logs the given message to stdout while prefixing the current time to it,
  * but only if debug logging was activated.
- * This is to be called by DLOG() which includes filename/linenumber
+ * This is called by libi3's DLOG() which includes filename/linenumber in fmt.
  *
  */
 void debuglog(char *fmt, ...) {
@@ -319,7 +487,24 @@ void debuglog(char *fmt, ...) {
         return;
 
     va_start(args, fmt);
-    vlog(debug_logging, fmt, args);
+    vlog(debug_logging, I3_SHMLOG_LEVEL_DEBUG, NULL, NULL, 0, fmt, args);
+    va_end(args);
+}
+
+/*
+ * Like debuglog(), but passes the source location separately so that the
+ * binary SHM log can store it without formatting it.
+ * This is to be called by DLOG().
+ *
+ */
+void debuglog_at(const char *file, const char *function, int line, char *fmt, ...) {
+    va_list args;
+
+    if (!logbuffer && !(debug_logging))
+        return;
+
+    va_start(args, fmt);
+    vlog(debug_logging, I3_SHMLOG_LEVEL_DEBUG, file, function, line, fmt, args);
     va_end(args);
 }
 
@@ -100,8 +100,15 @@ static void xcb_got_event(EV_P_ struct ev_io *w, int revents) {
 /*
  * Flush before blocking (and waiting for new events)
  *
+ * Before that, handle the property replies which arrived and fetch the
+ * properties the last batch of events announced changes for, see
+ * handle_pending_properties(), and do the render the batch requested, see
+ * tree_request_render().
+ *
  */
 static void xcb_prepare_cb(EV_P_ ev_prepare *w, int revents) {
+    handle_pending_properties();
+    tree_render_pending();
     xcb_flush(conn);
 }
 
@@ -115,10 +122,12 @@ static void xcb_check_cb(EV_P_ ev_check *w, int revents) {
 
     while ((event = xcb_poll_for_event(conn)) != NULL) {
         if (event->response_type == 0) {
-            if (event_is_ignored(event->sequence, 0))
+            xcb_generic_error_t *error = (xcb_generic_error_t *)event;
+            if (manage_handle_error(error))
+                DLOG("X11 Error received for a window which was being managed\n");
+            else if (event_is_ignored(event->sequence, 0))
                 DLOG("Expected X11 Error received for sequence %x\n", event->sequence);
             else {
-                xcb_generic_error_t *error = (xcb_generic_error_t *)event;
                 DLOG("X11 Error received (probably harmless)! sequence 0x%x, error_code = %d\n",
                      error->sequence, error->error_code);
             }
@@ -212,6 +221,7 @@ int main(int argc, char *argv[]) {
         {"disable-signalhandler", no_argument, 0, 0},
         {"shmlog-size", required_argument, 0, 0},
         {"shmlog_size", required_argument, 0, 0},
+        {"shmlog-binary", no_argument, 0, 0},
         {"get-socketpath", no_argument, 0, 0},
         {"get_socketpath", no_argument, 0, 0},
         {"fake_outputs", required_argument, 0, 0},
@@ -309,6 +319,10 @@ int main(int argc, char *argv[]) {
                     init_logging();
                     LOG("Limiting SHM log size to %d bytes\n", shmlog_size);
                     break;
+                } else if (strcmp(long_options[option_index].name, "shmlog-binary") == 0) {
+                    set_shmlog_binary(true);
+                    LOG("Using binary records for the SHM log\n");
+                    break;
                 } else if (strcmp(long_options[option_index].name, "restart") == 0) {
                     FREE(layout_path);
                     layout_path = sstrdup(optarg);
@@ -350,6 +364,11 @@ int main(int argc, char *argv[]) {
                                 "\tThe default is %d bytes.\n",
                         shmlog_size);
                 fprintf(stderr, "\n");
+                fprintf(stderr, "\t--shmlog-binary\n"
+                                "\tStore binary records instead of text lines in the SHM log. This\n"
+                                "\tmakes logging cheaper, timestamps and source locations are only\n"
+                                "\tformatted by i3-dump-log.\n");
+                fprintf(stderr, "\n");
                 fprintf(stderr, "If you pass plain text arguments, i3 will interpret them as a command\n"
                                 "to send to a currently running i3 (like i3-msg). This allows you to\n"
                                 "use nice and logical commands, such as:\n"
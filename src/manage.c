@@ -14,34 +14,193 @@
 
 #include <yajl/yajl_gen.h>
 
+/*
+ * The requests whose replies manage_window() needs. They are all sent before
+ * waiting for the first reply, so that adopting many windows at once (see
+ * manage_existing_windows()) costs a few round trips in total instead of a few
+ * round trips per window.
+ *
+ */
+struct manage_requests {
+    xcb_window_t window;
+    xcb_get_window_attributes_cookie_t attr_cookie;
+    xcb_get_geometry_cookie_t geom_cookie;
+    xcb_get_property_cookie_t wm_type_cookie, strut_cookie, state_cookie,
+        utf8_title_cookie, title_cookie,
+        class_cookie, leader_cookie, transient_cookie,
+        role_cookie, startup_id_cookie, wm_hints_cookie,
+        wm_normal_hints_cookie, motif_wm_hints_cookie, protocols_cookie;
+};
+
+/*
+ * Handles an X11 error for one of the requests sent while managing a window.
+ * Such an error means that the window was destroyed before we could set our
+ * event mask or reparent it, so it is unmanaged again. Returns false if the
+ * error does not belong to such a request.
+ *
+ */
+bool manage_handle_error(xcb_generic_error_t *error) {
+    const xcb_window_t window = watched_request_failed(error->full_sequence);
+    if (window == XCB_NONE)
+        return false;
+
+    LOG("Window 0x%08x disappeared while it was being managed (error_code = %d)\n",
+        window, error->error_code);
+
+    Con *con = con_by_window_id(window);
+    if (con != NULL) {
+        tree_close(con, DONT_KILL_WINDOW, false, false);
+        tree_request_render();
+    }
+    return true;
+}
+
+/*
+ * Returns true if the window with the given attributes should be managed.
+ *
+ */
+static bool should_manage(xcb_window_t window, xcb_get_window_attributes_reply_t *attr,
+                          bool needs_to_be_mapped) {
+    /* Check if the window is mapped (it could be not mapped when intializing and
+       calling manage_window() for every window) */
+    if (needs_to_be_mapped && attr->map_state != XCB_MAP_STATE_VIEWABLE)
+        return false;
+
+    /* Don’t manage clients with the override_redirect flag */
+    if (attr->override_redirect)
+        return false;
+
+    /* Check if the window is already managed */
+    if (con_by_window_id(window) != NULL) {
+        DLOG("already managed (by con %p)\n", con_by_window_id(window));
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Sets the temporary event mask of the window and requests all of its
+ * properties which we need to manage it.
+ *
+ */
+static void send_property_requests(struct manage_requests *req) {
+    const xcb_window_t window = req->window;
+    uint32_t values[1];
+
+    /* Set a temporary event mask for the new window, consisting only of
+     * PropertyChange and StructureNotify. We need to be notified of
+     * PropertyChanges because the client can change its properties *after* we
+     * requested them but *before* we actually reparented it and have set our
+     * final event mask.
+     * We need StructureNotify because the client may unmap the window before
+     * we get to re-parent it.
+     * If this request fails, we assume the client has already unmapped the
+     * window between the MapRequest and our event mask change. */
+    values[0] = XCB_EVENT_MASK_PROPERTY_CHANGE |
+                XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+    add_watched_request(xcb_change_window_attributes(conn, window, XCB_CW_EVENT_MASK, values).sequence, window);
+
+#define GET_PROPERTY(atom, len) xcb_get_property(conn, false, window, atom, XCB_GET_PROPERTY_TYPE_ANY, 0, len)
+
+    req->wm_type_cookie = GET_PROPERTY(A__NET_WM_WINDOW_TYPE, UINT32_MAX);
+    req->strut_cookie = GET_PROPERTY(A__NET_WM_STRUT_PARTIAL, UINT32_MAX);
+    req->state_cookie = GET_PROPERTY(A__NET_WM_STATE, UINT32_MAX);
+    req->utf8_title_cookie = GET_PROPERTY(A__NET_WM_NAME, 128);
+    req->leader_cookie = GET_PROPERTY(A_WM_CLIENT_LEADER, UINT32_MAX);
+    req->transient_cookie = GET_PROPERTY(XCB_ATOM_WM_TRANSIENT_FOR, UINT32_MAX);
+    req->title_cookie = GET_PROPERTY(XCB_ATOM_WM_NAME, 128);
+    req->class_cookie = GET_PROPERTY(XCB_ATOM_WM_CLASS, 128);
+    req->role_cookie = GET_PROPERTY(A_WM_WINDOW_ROLE, 128);
+    req->startup_id_cookie = GET_PROPERTY(A__NET_STARTUP_ID, 512);
+    req->wm_hints_cookie = xcb_icccm_get_wm_hints(conn, window);
+    req->wm_normal_hints_cookie = xcb_icccm_get_wm_normal_hints(conn, window);
+    req->motif_wm_hints_cookie = GET_PROPERTY(A__MOTIF_WM_HINTS, 5 * sizeof(uint64_t));
+    req->protocols_cookie = xcb_icccm_get_wm_protocols(conn, window, A_WM_PROTOCOLS);
+
+#undef GET_PROPERTY
+}
+
+/*
+ * Discards the replies to the requests of send_property_requests().
+ *
+ */
+static void discard_property_requests(struct manage_requests *req) {
+    xcb_get_property_cookie_t cookies[] = {
+        req->wm_type_cookie, req->strut_cookie, req->state_cookie,
+        req->utf8_title_cookie, req->title_cookie,
+        req->class_cookie, req->leader_cookie, req->transient_cookie,
+        req->role_cookie, req->startup_id_cookie, req->wm_hints_cookie,
+        req->wm_normal_hints_cookie, req->motif_wm_hints_cookie, req->protocols_cookie};
+
+    for (size_t i = 0; i < sizeof(cookies) / sizeof(cookies[0]); i++)
+        xcb_discard_reply(conn, cookies[i].sequence);
+}
+
+static void manage_window_replies(struct manage_requests *req, xcb_get_window_attributes_reply_t *attr);
+
 /*
  * Go through all existing windows (if the window manager is restarted) and manage them
  *
+ * This happens in three phases, so that we never wait for the replies of one
+ * window before the requests for all the other windows are sent: first, the
+ * attributes and geometry of all windows are requested. Then, for each window
+ * which we are going to manage, the properties are requested. Finally, the
+ * windows are managed using the replies, which by then have mostly arrived.
+ *
  */
 void manage_existing_windows(xcb_window_t root) {
     xcb_query_tree_reply_t *reply;
     int i, len;
     xcb_window_t *children;
-    xcb_get_window_attributes_cookie_t *cookies;
+    const ev_tstamp start = ev_time();
 
     /* Get the tree of windows whose parent is the root window (= all) */
     if ((reply = xcb_query_tree_reply(conn, xcb_query_tree(conn, root), 0)) == NULL)
         return;
 
     len = xcb_query_tree_children_length(reply);
-    cookies = smalloc(len * sizeof(*cookies));
+    struct manage_requests *requests = scalloc(len * sizeof(struct manage_requests));
+    xcb_get_window_attributes_reply_t **attrs = scalloc(len * sizeof(xcb_get_window_attributes_reply_t *));
 
-    /* Request the window attributes for every window */
+    /* Request the window attributes and geometry for every window */
     children = xcb_query_tree_children(reply);
-    for (i = 0; i < len; ++i)
-        cookies[i] = xcb_get_window_attributes(conn, children[i]);
+    for (i = 0; i < len; ++i) {
+        requests[i].window = children[i];
+        requests[i].attr_cookie = xcb_get_window_attributes(conn, children[i]);
+        requests[i].geom_cookie = xcb_get_geometry(conn, children[i]);
+    }
+
+    /* Request the properties of every window we are going to manage */
+    int managed = 0;
+    for (i = 0; i < len; ++i) {
+        attrs[i] = xcb_get_window_attributes_reply(conn, requests[i].attr_cookie, 0);
+        if (attrs[i] == NULL || !should_manage(children[i], attrs[i], true)) {
+            xcb_discard_reply(conn, requests[i].geom_cookie.sequence);
+            FREE(attrs[i]);
+            continue;
+        }
+        send_property_requests(&(requests[i]));
+        managed++;
+    }
+    xcb_flush(conn);
 
-    /* Call manage_window with the attributes for every window */
-    for (i = 0; i < len; ++i)
-        manage_window(children[i], cookies[i], true);
+    const ev_tstamp requested = ev_time();
+
+    /* Manage every window with the replies */
+    for (i = 0; i < len; ++i) {
+        if (attrs[i] == NULL)
+            continue;
+        manage_window_replies(&(requests[i]), attrs[i]);
+    }
+
+    const ev_tstamp done = ev_time();
+    LOG("Managing %d of %d existing windows took %.3f ms (%.3f ms for requesting, %.3f ms for managing)\n",
+        managed, len, (done - start) * 1000, (requested - start) * 1000, (done - requested) * 1000);
 
     free(reply);
-    free(cookies);
+    free(requests);
+    free(attrs);
 }
 
 /*
@@ -81,87 +240,45 @@ void restore_geometry(void) {
  */
 void manage_window(xcb_window_t window, xcb_get_window_attributes_cookie_t cookie,
                    bool needs_to_be_mapped) {
-    xcb_drawable_t d = {window};
-    xcb_get_geometry_cookie_t geomc;
-    xcb_get_geometry_reply_t *geom;
     xcb_get_window_attributes_reply_t *attr = NULL;
+    struct manage_requests req = {
+        .window = window,
+        .attr_cookie = cookie,
+        .geom_cookie = xcb_get_geometry(conn, window)};
 
-    xcb_get_property_cookie_t wm_type_cookie, strut_cookie, state_cookie,
-        utf8_title_cookie, title_cookie,
-        class_cookie, leader_cookie, transient_cookie,
-        role_cookie, startup_id_cookie, wm_hints_cookie,
-        wm_normal_hints_cookie, motif_wm_hints_cookie;
-
-    geomc = xcb_get_geometry(conn, d);
-
-    /* Check if the window is mapped (it could be not mapped when intializing and
-       calling manage_window() for every window) */
     if ((attr = xcb_get_window_attributes_reply(conn, cookie, 0)) == NULL) {
         DLOG("Could not get attributes\n");
-        xcb_discard_reply(conn, geomc.sequence);
+        xcb_discard_reply(conn, req.geom_cookie.sequence);
         return;
     }
 
-    if (needs_to_be_mapped && attr->map_state != XCB_MAP_STATE_VIEWABLE) {
-        xcb_discard_reply(conn, geomc.sequence);
-        goto out;
+    if (!should_manage(window, attr, needs_to_be_mapped)) {
+        xcb_discard_reply(conn, req.geom_cookie.sequence);
+        free(attr);
+        return;
     }
 
-    /* Don’t manage clients with the override_redirect flag */
-    if (attr->override_redirect) {
-        xcb_discard_reply(conn, geomc.sequence);
-        goto out;
-    }
+    send_property_requests(&req);
+    manage_window_replies(&req, attr);
+}
 
-    /* Check if the window is already managed */
-    if (con_by_window_id(window) != NULL) {
-        DLOG("already managed (by con %p)\n", con_by_window_id(window));
-        xcb_discard_reply(conn, geomc.sequence);
-        goto out;
-    }
+/*
+ * Manages the window using the replies to the given requests. Takes ownership
+ * of attr.
+ *
+ */
+static void manage_window_replies(struct manage_requests *req, xcb_get_window_attributes_reply_t *attr) {
+    const xcb_window_t window = req->window;
+    xcb_get_geometry_reply_t *geom;
+    uint32_t values[1];
 
     /* Get the initial geometry (position, size, …) */
-    if ((geom = xcb_get_geometry_reply(conn, geomc, 0)) == NULL) {
+    if ((geom = xcb_get_geometry_reply(conn, req->geom_cookie, 0)) == NULL) {
         DLOG("could not get geometry\n");
+        discard_property_requests(req);
         goto out;
     }
 
-    uint32_t values[1];
-
-    /* Set a temporary event mask for the new window, consisting only of
-     * PropertyChange and StructureNotify. We need to be notified of
-     * PropertyChanges because the client can change its properties *after* we
-     * requested them but *before* we actually reparented it and have set our
-     * final event mask.
-     * We need StructureNotify because the client may unmap the window before
-     * we get to re-parent it.
-     * If this request fails, we assume the client has already unmapped the
-     * window between the MapRequest and our event mask change. */
-    values[0] = XCB_EVENT_MASK_PROPERTY_CHANGE |
-                XCB_EVENT_MASK_STRUCTURE_NOTIFY;
-    xcb_void_cookie_t event_mask_cookie =
-        xcb_change_window_attributes_checked(conn, window, XCB_CW_EVENT_MASK, values);
-    if (xcb_request_check(conn, event_mask_cookie) != NULL) {
-        LOG("Could not change event mask, the window probably already disappeared.\n");
-        goto out;
-    }
-
-#define GET_PROPERTY(atom, len) xcb_get_property(conn, false, window, atom, XCB_GET_PROPERTY_TYPE_ANY, 0, len)
-
-    wm_type_cookie = GET_PROPERTY(A__NET_WM_WINDOW_TYPE, UINT32_MAX);
-    strut_cookie = GET_PROPERTY(A__NET_WM_STRUT_PARTIAL, UINT32_MAX);
-    state_cookie = GET_PROPERTY(A__NET_WM_STATE, UINT32_MAX);
-    utf8_title_cookie = GET_PROPERTY(A__NET_WM_NAME, 128);
-    leader_cookie = GET_PROPERTY(A_WM_CLIENT_LEADER, UINT32_MAX);
-    transient_cookie = GET_PROPERTY(XCB_ATOM_WM_TRANSIENT_FOR, UINT32_MAX);
-    title_cookie = GET_PROPERTY(XCB_ATOM_WM_NAME, 128);
-    class_cookie = GET_PROPERTY(XCB_ATOM_WM_CLASS, 128);
-    role_cookie = GET_PROPERTY(A_WM_WINDOW_ROLE, 128);
-    startup_id_cookie = GET_PROPERTY(A__NET_STARTUP_ID, 512);
-    wm_hints_cookie = xcb_icccm_get_wm_hints(conn, window);
-    wm_normal_hints_cookie = xcb_icccm_get_wm_normal_hints(conn, window);
-    motif_wm_hints_cookie = GET_PROPERTY(A__MOTIF_WM_HINTS, 5 * sizeof(uint64_t));
-
     DLOG("Managing window 0x%08x\n", window);
 
     i3Window *cwindow = scalloc(sizeof(i3Window));
@@ -176,30 +293,30 @@ void manage_window(xcb_window_t window, xcb_get_window_attributes_cookie_t cooki
                     XCB_BUTTON_MASK_ANY /* don’t filter for any modifiers */);
 
     /* update as much information as possible so far (some replies may be NULL) */
-    window_update_class(cwindow, xcb_get_property_reply(conn, class_cookie, NULL), true);
-    window_update_name_legacy(cwindow, xcb_get_property_reply(conn, title_cookie, NULL), true);
-    window_update_name(cwindow, xcb_get_property_reply(conn, utf8_title_cookie, NULL), true);
-    window_update_leader(cwindow, xcb_get_property_reply(conn, leader_cookie, NULL));
-    window_update_transient_for(cwindow, xcb_get_property_reply(conn, transient_cookie, NULL));
-    window_update_strut_partial(cwindow, xcb_get_property_reply(conn, strut_cookie, NULL));
-    window_update_role(cwindow, xcb_get_property_reply(conn, role_cookie, NULL), true);
+    window_update_class(cwindow, xcb_get_property_reply(conn, req->class_cookie, NULL), true);
+    window_update_name_legacy(cwindow, xcb_get_property_reply(conn, req->title_cookie, NULL), true);
+    window_update_name(cwindow, xcb_get_property_reply(conn, req->utf8_title_cookie, NULL), true);
+    window_update_leader(cwindow, xcb_get_property_reply(conn, req->leader_cookie, NULL));
+    window_update_transient_for(cwindow, xcb_get_property_reply(conn, req->transient_cookie, NULL));
+    window_update_strut_partial(cwindow, xcb_get_property_reply(conn, req->strut_cookie, NULL));
+    window_update_role(cwindow, xcb_get_property_reply(conn, req->role_cookie, NULL), true);
     bool urgency_hint;
-    window_update_hints(cwindow, xcb_get_property_reply(conn, wm_hints_cookie, NULL), &urgency_hint);
+    window_update_hints(cwindow, xcb_get_property_reply(conn, req->wm_hints_cookie, NULL), &urgency_hint);
     border_style_t motif_border_style = BS_NORMAL;
-    window_update_motif_hints(cwindow, xcb_get_property_reply(conn, motif_wm_hints_cookie, NULL), &motif_border_style);
+    window_update_motif_hints(cwindow, xcb_get_property_reply(conn, req->motif_wm_hints_cookie, NULL), &motif_border_style);
     xcb_size_hints_t wm_size_hints;
-    if (!xcb_icccm_get_wm_size_hints_reply(conn, wm_normal_hints_cookie, &wm_size_hints, NULL))
+    if (!xcb_icccm_get_wm_size_hints_reply(conn, req->wm_normal_hints_cookie, &wm_size_hints, NULL))
         memset(&wm_size_hints, '\0', sizeof(xcb_size_hints_t));
-    xcb_get_property_reply_t *type_reply = xcb_get_property_reply(conn, wm_type_cookie, NULL);
-    xcb_get_property_reply_t *state_reply = xcb_get_property_reply(conn, state_cookie, NULL);
+    xcb_get_property_reply_t *type_reply = xcb_get_property_reply(conn, req->wm_type_cookie, NULL);
+    xcb_get_property_reply_t *state_reply = xcb_get_property_reply(conn, req->state_cookie, NULL);
 
     xcb_get_property_reply_t *startup_id_reply;
-    startup_id_reply = xcb_get_property_reply(conn, startup_id_cookie, NULL);
+    startup_id_reply = xcb_get_property_reply(conn, req->startup_id_cookie, NULL);
     char *startup_ws = startup_workspace_for_window(cwindow, startup_id_reply);
     DLOG("startup workspace = %s\n", startup_ws);
 
     /* check if the window needs WM_TAKE_FOCUS */
-    cwindow->needs_take_focus = window_supports_protocol(cwindow->id, A_WM_TAKE_FOCUS);
+    cwindow->needs_take_focus = window_protocols_contain(req->protocols_cookie, A_WM_TAKE_FOCUS);
 
     /* read the preferred _NET_WM_WINDOW_TYPE atom */
     cwindow->window_type = xcb_get_preferred_window_type(type_reply);
@@ -303,7 +420,10 @@ void manage_window(xcb_window_t window, xcb_get_window_attributes_cookie_t cooki
             DLOG("Uh?! Container without a placeholder, but with a window, has swallowed this to-be-managed window?!\n");
         }
     }
+    con_index_remove_window(nc);
     nc->window = cwindow;
+    con_index_add_window(nc);
+    tree_diff_changed(nc, TC_WINDOW | TC_NAME);
     x_reinit(nc);
 
     nc->border_width = geom->border_width;
@@ -466,11 +586,9 @@ void manage_window(xcb_window_t window, xcb_get_window_attributes_cookie_t cooki
     values[0] = XCB_NONE;
     xcb_change_window_attributes(conn, window, XCB_CW_EVENT_MASK, values);
 
-    xcb_void_cookie_t rcookie = xcb_reparent_window_checked(conn, window, nc->frame, 0, 0);
-    if (xcb_request_check(conn, rcookie) != NULL) {
-        LOG("Could not reparent the window, aborting\n");
-        goto geom_out;
-    }
+    /* If the window is already gone, this fails and the window is unmanaged
+     * again in manage_handle_error(). */
+    add_watched_request(xcb_reparent_window(conn, window, nc->frame, 0, 0).sequence, window);
 
     values[0] = CHILD_EVENT_MASK & ~XCB_EVENT_MASK_ENTER_WINDOW;
     xcb_change_window_attributes(conn, window, XCB_CW_EVENT_MASK, values);
@@ -531,7 +649,6 @@ void manage_window(xcb_window_t window, xcb_get_window_attributes_cookie_t cooki
      * needs to be on the final workspace first. */
     con_set_urgency(nc, urgency_hint);
 
-geom_out:
     free(geom);
 out:
     free(attr);
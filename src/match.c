@@ -64,9 +64,8 @@ bool match_is_empty(Match *match) {
 void match_copy(Match *dest, Match *src) {
     memcpy(dest, src, sizeof(Match));
 
-/* The DUPLICATE_REGEX macro creates a new regular expression from the
- * ->pattern of the old one. It therefore does use a little more memory then
- *  with a refcounting system, but it’s easier this way. */
+/* The DUPLICATE_REGEX macro gets another reference to the regular expression
+ * of the old one from the regex cache, so nothing is compiled. */
 #define DUPLICATE_REGEX(field)                            \
     do {                                                  \
         if (src->field != NULL)                           \
@@ -87,12 +86,12 @@ void match_copy(Match *dest, Match *src) {
  *
  */
 bool match_matches_window(Match *match, i3Window *window) {
-    LOG("Checking window 0x%08x (class %s)\n", window->id, window->class_class);
+    DLOG("Checking window 0x%08x (class %s)\n", window->id, window->class_class);
 
     if (match->class != NULL) {
         if (window->class_class != NULL &&
             regex_matches(match->class, window->class_class)) {
-            LOG("window class matches (%s)\n", window->class_class);
+            DLOG("window class matches (%s)\n", window->class_class);
         } else {
             return false;
         }
@@ -101,7 +100,7 @@ bool match_matches_window(Match *match, i3Window *window) {
     if (match->instance != NULL) {
         if (window->class_instance != NULL &&
             regex_matches(match->instance, window->class_instance)) {
-            LOG("window instance matches (%s)\n", window->class_instance);
+            DLOG("window instance matches (%s)\n", window->class_instance);
         } else {
             return false;
         }
@@ -109,9 +108,9 @@ bool match_matches_window(Match *match, i3Window *window) {
 
     if (match->id != XCB_NONE) {
         if (window->id == match->id) {
-            LOG("match made by window id (%d)\n", window->id);
+            DLOG("match made by window id (%d)\n", window->id);
         } else {
-            LOG("window id does not match\n");
+            DLOG("window id does not match\n");
             return false;
         }
     }
@@ -119,7 +118,7 @@ bool match_matches_window(Match *match, i3Window *window) {
     if (match->title != NULL) {
         if (window->name != NULL &&
             regex_matches(match->title, i3string_as_utf8(window->name))) {
-            LOG("title matches (%s)\n", i3string_as_utf8(window->name));
+            DLOG("title matches (%s)\n", i3string_as_utf8(window->name));
         } else {
             return false;
         }
@@ -128,7 +127,7 @@ bool match_matches_window(Match *match, i3Window *window) {
     if (match->window_role != NULL) {
         if (window->role != NULL &&
             regex_matches(match->window_role, window->role)) {
-            LOG("window_role matches (%s)\n", window->role);
+            DLOG("window_role matches (%s)\n", window->role);
         } else {
             return false;
         }
@@ -136,7 +135,7 @@ bool match_matches_window(Match *match, i3Window *window) {
 
     if (match->window_type != UINT32_MAX) {
         if (window->window_type == match->window_type) {
-            LOG("window_type matches (%i)\n", match->window_type);
+            DLOG("window_type matches (%i)\n", match->window_type);
         } else {
             return false;
         }
@@ -155,7 +154,7 @@ bool match_matches_window(Match *match, i3Window *window) {
                 return false;
             }
         }
-        LOG("urgent matches latest\n");
+        DLOG("urgent matches latest\n");
     }
 
     if (match->urgent == U_OLDEST) {
@@ -171,7 +170,7 @@ bool match_matches_window(Match *match, i3Window *window) {
                 return false;
             }
         }
-        LOG("urgent matches oldest\n");
+        DLOG("urgent matches oldest\n");
     }
 
     if (match->workspace != NULL) {
@@ -183,7 +182,7 @@ bool match_matches_window(Match *match, i3Window *window) {
             return false;
 
         if (regex_matches(match->workspace, ws->name)) {
-            LOG("workspace matches (%s)\n", ws->name);
+            DLOG("workspace matches (%s)\n", ws->name);
         } else {
             return false;
         }
@@ -195,9 +194,9 @@ bool match_matches_window(Match *match, i3Window *window) {
             ((window->dock == W_DOCK_TOP || window->dock == W_DOCK_BOTTOM) &&
              match->dock == M_DOCK_ANY) ||
             (window->dock == W_NODOCK && match->dock == M_NODOCK)) {
-            LOG("dock status matches\n");
+            DLOG("dock status matches\n");
         } else {
-            LOG("dock status does not match\n");
+            DLOG("dock status does not match\n");
             return false;
         }
     }
@@ -205,7 +204,7 @@ bool match_matches_window(Match *match, i3Window *window) {
     /* We don’t check the mark because this function is not even called when
      * the mark would have matched - it is checked in cmdparse.y itself */
     if (match->mark != NULL) {
-        LOG("mark does not match\n");
+        DLOG("mark does not match\n");
         return false;
     }
 
@@ -217,19 +216,20 @@ bool match_matches_window(Match *match, i3Window *window) {
  *
  */
 void match_free(Match *match) {
-    /* First step: free the regex fields / patterns */
+    /* The regexes are shared, regex_free() only releases our reference. */
     regex_free(match->title);
     regex_free(match->application);
     regex_free(match->class);
     regex_free(match->instance);
     regex_free(match->mark);
     regex_free(match->window_role);
-
-    /* Second step: free the regex helper struct itself */
-    FREE(match->title);
-    FREE(match->application);
-    FREE(match->class);
-    FREE(match->instance);
-    FREE(match->mark);
-    FREE(match->window_role);
+    regex_free(match->workspace);
+
+    match->title = NULL;
+    match->application = NULL;
+    match->class = NULL;
+    match->instance = NULL;
+    match->mark = NULL;
+    match->window_role = NULL;
+    match->workspace = NULL;
 }
@@ -55,6 +55,8 @@ static void insert_con_into(Con *con, Con *target, position_t position) {
         TAILQ_INSERT_AFTER(&(parent->nodes_head), target, con, nodes);
         TAILQ_INSERT_HEAD(&(parent->focus_head), con, focused);
     }
+    tree_diff_changed(con, TC_PARENT);
+    tree_diff_changed(parent, TC_NODES);
 
     /* Pretend the con was just opened with regards to size percent values.
      * Since the con is moved to a completely different con, the old value
@@ -86,6 +88,8 @@ static void attach_to_workspace(Con *con, Con *ws, direction_t direction) {
         TAILQ_INSERT_TAIL(&(ws->nodes_head), con, nodes);
         TAILQ_INSERT_TAIL(&(ws->focus_head), con, focused);
     }
+    tree_diff_changed(con, TC_PARENT);
+    tree_diff_changed(ws, TC_NODES);
 
     /* Pretend the con was just opened with regards to size percent values.
      * Since the con is moved to a completely different con, the old value
@@ -142,6 +146,13 @@ void tree_move(Con *con, int direction) {
 
     DLOG("Moving in direction %d\n", direction);
 
+    /* The gaps of a container depend on its position among its siblings, so
+     * every move invalidates the workspace it starts on. Moves into another
+     * container or workspace also invalidate their destination when fixing
+     * its percentages, but swapping two siblings does not touch anything
+     * else which would. */
+    con_invalidate(con);
+
     /* 1: get the first parent with the same orientation */
 
     if (con->type == CT_WORKSPACE) {
@@ -200,6 +211,7 @@ void tree_move(Con *con, int direction) {
                     TAILQ_SWAP(swap, con, &(swap->parent->nodes_head), nodes);
                 else
                     TAILQ_SWAP(con, swap, &(swap->parent->nodes_head), nodes);
+                tree_diff_changed(swap->parent, TC_NODES);
 
                 TAILQ_REMOVE(&(con->parent->focus_head), con, focused);
                 TAILQ_INSERT_HEAD(&(swap->parent->focus_head), con, focused);
@@ -495,10 +495,13 @@ static void output_change_mode(xcb_connection_t *conn, Output *output) {
                 continue;
 
             workspace->layout = (output->rect.height > output->rect.width) ? L_SPLITV : L_SPLITH;
+            tree_diff_changed(workspace, TC_LAYOUT);
             DLOG("Setting workspace [%d,%s]'s layout to %d.\n", workspace->num, workspace->name, workspace->layout);
             if ((child = TAILQ_FIRST(&(workspace->nodes_head)))) {
-                if (child->layout == L_SPLITV || child->layout == L_SPLITH)
+                if (child->layout == L_SPLITV || child->layout == L_SPLITH) {
                     child->layout = workspace->layout;
+                    tree_diff_changed(child, TC_LAYOUT);
+                }
                 DLOG("Setting child [%d,%s]'s layout to %d.\n", child->num, child->name, child->layout);
             }
         }
@@ -847,6 +850,9 @@ void randr_query_outputs(void) {
                 die("No usable outputs available.\n");
         }
     }
+
+    /* Output sizes and workspace orientations might have changed. */
+    con_invalidate(croot);
 }
 
 /*
@@ -11,17 +11,112 @@
  */
 #include "all.h"
 
+/* Number of hash buckets of the regex cache. Has to be a power of two. */
+#define REGEX_CACHE_BUCKETS 64
+/* How many regexes which are not used by any Match anymore are kept. */
+#define REGEX_CACHE_MAX_UNUSED 64
+
+/* All regexes, referenced or not, by hash of their pattern. */
+static SLIST_HEAD(regex_bucket, regex) regex_cache[REGEX_CACHE_BUCKETS];
+/* Regexes with a refcount of 0, least recently released first. */
+static TAILQ_HEAD(unused_regexes_head, regex) unused_regexes =
+    TAILQ_HEAD_INITIALIZER(unused_regexes);
+static int unused_count = 0;
+
 /*
- * Creates a new 'regex' struct containing the given pattern and a PCRE
- * compiled regular expression. Also, calls pcre_study because this regex will
- * most likely be used often (like for every new window and on every relevant
- * property change of existing windows).
+ * 32 bit FNV-1a of the pattern.
  *
- * Returns NULL if the pattern could not be compiled into a regular expression
- * (and ELOGs an appropriate error message).
+ */
+static uint32_t hash_pattern(const char *pattern) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *walk = (const unsigned char *)pattern; *walk != '\0'; walk++) {
+        hash ^= *walk;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*
+ * Checks whether the pattern is a plain string, optionally anchored with ^
+ * and/or $, and if so, sets up the literal fields of the regex.
  *
  */
-struct regex *regex_new(const char *pattern) {
+static void regex_detect_literal(struct regex *re) {
+    const char *start = re->pattern;
+    size_t len = strlen(start);
+    bool anchored_start = false,
+         anchored_end = false;
+
+    if (len > 0 && start[0] == '^') {
+        anchored_start = true;
+        start++;
+        len--;
+    }
+    if (len > 0 && start[len - 1] == '$') {
+        anchored_end = true;
+        len--;
+    }
+
+    /* An escaped $ leaves a trailing backslash, which is caught here. */
+    for (size_t i = 0; i < len; i++) {
+        if (strchr("\\^$.|?*+()[]{}", start[i]) != NULL)
+            return;
+    }
+
+    re->literal = sstrndup(start, len);
+    re->literal_len = len;
+    if (anchored_start && anchored_end)
+        re->literal_type = RE_LITERAL_EXACT;
+    else if (anchored_start)
+        re->literal_type = RE_LITERAL_PREFIX;
+    else if (anchored_end)
+        re->literal_type = RE_LITERAL_SUFFIX;
+    else
+        re->literal_type = RE_LITERAL_CONTAINS;
+}
+
+/*
+ * Returns true if the first input_len bytes of input end with the literal.
+ *
+ */
+static bool literal_ends(const struct regex *regex, const char *input, size_t input_len) {
+    return (input_len >= regex->literal_len &&
+            memcmp(input + input_len - regex->literal_len, regex->literal, regex->literal_len) == 0);
+}
+
+/*
+ * Matches a literal pattern like PCRE would. Note that $ also matches before
+ * a newline at the end of the input.
+ *
+ */
+static bool literal_matches(const struct regex *regex, const char *input) {
+    const size_t input_len = strlen(input);
+    const bool trailing_newline = (input_len > 0 && input[input_len - 1] == '\n');
+
+    switch (regex->literal_type) {
+        case RE_LITERAL_CONTAINS:
+            return (strstr(input, regex->literal) != NULL);
+        case RE_LITERAL_PREFIX:
+            return (strncmp(input, regex->literal, regex->literal_len) == 0);
+        case RE_LITERAL_SUFFIX:
+            return (literal_ends(regex, input, input_len) ||
+                    (trailing_newline && literal_ends(regex, input, input_len - 1)));
+        case RE_LITERAL_EXACT:
+            return ((input_len == regex->literal_len ||
+                     (trailing_newline && input_len == regex->literal_len + 1)) &&
+                    memcmp(input, regex->literal, regex->literal_len) == 0);
+        case RE_LITERAL_NONE:
+            break;
+    }
+    return false;
+}
+
+/*
+ * Compiles the given pattern. Literal patterns are still compiled, so that
+ * invalid ones are rejected just like before, but not studied.
+ *
+ */
+static struct regex *regex_compile(const char *pattern) {
     const char *error;
     int errorcode, offset;
 
@@ -42,9 +137,20 @@ struct regex *regex_new(const char *pattern) {
         }
         ELOG("PCRE regular expression compilation failed at %d: %s\n",
              offset, error);
+        FREE(re->pattern);
+        FREE(re);
         return NULL;
     }
+
+    regex_detect_literal(re);
+    if (re->literal_type != RE_LITERAL_NONE)
+        return re;
+
+#ifdef PCRE_STUDY_JIT_COMPILE
+    re->extra = pcre_study(re->regex, PCRE_STUDY_JIT_COMPILE, &error);
+#else
     re->extra = pcre_study(re->regex, 0, &error);
+#endif
     /* If an error happened, we print the error message, but continue.
      * Studying the regular expression leads to faster matching, but it’s not
      * absolutely necessary. */
@@ -54,16 +160,76 @@ struct regex *regex_new(const char *pattern) {
     return re;
 }
 
+static void regex_destroy(struct regex *regex) {
+    FREE(regex->pattern);
+    FREE(regex->literal);
+    FREE(regex->regex);
+#ifdef PCRE_STUDY_JIT_COMPILE
+    pcre_free_study(regex->extra);
+#else
+    FREE(regex->extra);
+#endif
+    FREE(regex);
+}
+
+/*
+ * Creates a new 'regex' struct containing the given pattern and a PCRE
+ * compiled regular expression. Also, calls pcre_study because this regex will
+ * most likely be used often (like for every new window and on every relevant
+ * property change of existing windows).
+ *
+ * Regexes are cached by pattern and shared, so this only compiles a pattern
+ * the first time it is seen (or when it was unused for a while).
+ *
+ * Returns NULL if the pattern could not be compiled into a regular expression
+ * (and ELOGs an appropriate error message).
+ *
+ */
+struct regex *regex_new(const char *pattern) {
+    const uint32_t hash = hash_pattern(pattern);
+    struct regex_bucket *bucket = &(regex_cache[hash & (REGEX_CACHE_BUCKETS - 1)]);
+    struct regex *re;
+
+    SLIST_FOREACH(re, bucket, cache_entries) {
+        if (re->hash != hash || strcmp(re->pattern, pattern) != 0)
+            continue;
+
+        if (re->refcount++ == 0) {
+            TAILQ_REMOVE(&unused_regexes, re, unused_regexes);
+            unused_count--;
+        }
+        return re;
+    }
+
+    if ((re = regex_compile(pattern)) == NULL)
+        return NULL;
+
+    re->hash = hash;
+    re->refcount = 1;
+    SLIST_INSERT_HEAD(bucket, re, cache_entries);
+    return re;
+}
+
 /*
- * Frees the given regular expression. It must not be used afterwards!
+ * Releases the given regular expression. It must not be used afterwards!
  *
  */
 void regex_free(struct regex *regex) {
     if (!regex)
         return;
-    FREE(regex->pattern);
-    FREE(regex->regex);
-    FREE(regex->extra);
+
+    if (--(regex->refcount) > 0)
+        return;
+
+    TAILQ_INSERT_TAIL(&unused_regexes, regex, unused_regexes);
+    if (++unused_count <= REGEX_CACHE_MAX_UNUSED)
+        return;
+
+    struct regex *oldest = TAILQ_FIRST(&unused_regexes);
+    TAILQ_REMOVE(&unused_regexes, oldest, unused_regexes);
+    unused_count--;
+    SLIST_REMOVE(&(regex_cache[oldest->hash & (REGEX_CACHE_BUCKETS - 1)]), oldest, regex, cache_entries);
+    regex_destroy(oldest);
 }
 
 /*
@@ -75,6 +241,13 @@ void regex_free(struct regex *regex) {
 bool regex_matches(struct regex *regex, const char *input) {
     int rc;
 
+    if (regex->literal_type != RE_LITERAL_NONE) {
+        const bool matches = literal_matches(regex, input);
+        LOG("Regular expression \"%s\" %s \"%s\"\n",
+            regex->pattern, (matches ? "matches" : "does not match"), input);
+        return matches;
+    }
+
     /* We use strlen() because pcre_exec() expects the length of the input
      * string in bytes */
     if ((rc = pcre_exec(regex->regex, regex->extra, input, strlen(input), 0, 0, NULL, 0)) == 0) {
@@ -16,6 +16,8 @@
  * container (for debugging purposes) */
 static bool show_debug_borders = false;
 
+struct render_stats render_stats;
+
 /*
  * Returns the height for the decorations
  */
@@ -158,6 +160,35 @@ bool has_adjacent_container(Con *con, direction_t direction) {
     return con_has_parent(fullscreen, con) && con_has_parent(fullscreen, second);
 }
 
+/*
+ * Computes the gaps inset of the given container. This is the expensive part
+ * of rendering a container: has_adjacent_container() has to search the whole
+ * workspace for fullscreen containers in every direction.
+ *
+ */
+static Rect calculate_inset(Con *con) {
+    gaps_t gaps = calculate_effective_gaps(con);
+    Rect inset = (Rect){
+        has_adjacent_container(con, D_LEFT) ? gaps.inner : gaps.outer,
+        has_adjacent_container(con, D_UP) ? gaps.inner : gaps.outer,
+        has_adjacent_container(con, D_RIGHT) ? -gaps.inner : -gaps.outer,
+        has_adjacent_container(con, D_DOWN) ? -gaps.inner : -gaps.outer};
+    inset.width -= inset.x;
+    inset.height -= inset.y;
+    return inset;
+}
+
+/*
+ * Returns true if the given container is part of a dirty subtree, that is,
+ * if the cached gaps of it cannot be used. Containers outside of workspaces
+ * are always considered dirty.
+ *
+ */
+static bool is_dirty(Con *con) {
+    Con *ws = con_get_workspace(con);
+    return (ws == NULL || ws->dirty || croot->dirty);
+}
+
 /*
  * "Renders" the given container (and its children), meaning that all rects are
  * updated correctly. Note that this function does not call any xcb_*
@@ -185,16 +216,28 @@ void render_con(Con *con, bool render_fullscreen, bool already_inset) {
         rect.height -= 2 * 2;
     }
 
+    if (con->type == CT_WORKSPACE)
+        con->render_frame = render_stats.frames;
+
+    render_stats.rendered++;
+
     bool should_inset = should_inset_con(con, children);
     if (!already_inset && should_inset) {
-        gaps_t gaps = calculate_effective_gaps(con);
-        Rect inset = (Rect){
-            has_adjacent_container(con, D_LEFT) ? gaps.inner : gaps.outer,
-            has_adjacent_container(con, D_UP) ? gaps.inner : gaps.outer,
-            has_adjacent_container(con, D_RIGHT) ? -gaps.inner : -gaps.outer,
-            has_adjacent_container(con, D_DOWN) ? -gaps.inner : -gaps.outer};
-        inset.width -= inset.x;
-        inset.height -= inset.y;
+        /* The gaps only depend on the tree structure and the gaps
+         * configuration, not on the rect of the container, so they can be
+         * re-used until con_invalidate() is called for this workspace. */
+        if (is_dirty(con) || !con->inset_valid) {
+            con->inset = calculate_inset(con);
+            con->inset_valid = true;
+            render_stats.gaps_recomputed++;
+        }
+#ifdef DEBUG_RENDER_CACHE
+        else {
+            Rect expected = calculate_inset(con);
+            assert(memcmp(&expected, &(con->inset), sizeof(Rect)) == 0);
+        }
+#endif
+        Rect inset = con->inset;
 
         rect = rect_add(rect, inset);
         if (!render_fullscreen) {
@@ -15,6 +15,14 @@ struct Con *croot;
 struct Con *focused;
 
 struct all_cons_head all_cons = TAILQ_HEAD_INITIALIZER(all_cons);
+struct marked_cons_head marked_cons = TAILQ_HEAD_INITIALIZER(marked_cons);
+
+/* What tree_render_pending() has to do, see tree_request_render(). */
+static enum {
+    RENDER_NONE = 0,
+    RENDER_PUSH = 1,
+    RENDER_FULL = 2
+} pending_render = RENDER_NONE;
 
 /*
  * Create the pseudo-output __i3. Output-independent workspaces such as
@@ -265,6 +273,7 @@ bool tree_close(Con *con, kill_window_t kill_window, bool dont_kill_parent, bool
             add_ignore_event(cookie.sequence, 0);
         }
         ipc_send_window_event("close", con);
+        con_index_remove_window(con);
         FREE(con->window->class_class);
         FREE(con->window->class_instance);
         i3string_free(con->window->name);
@@ -324,6 +333,8 @@ bool tree_close(Con *con, kill_window_t kill_window, bool dont_kill_parent, bool
         DLOG("parent container killed\n");
     }
 
+    con_unmark(con);
+    tree_diff_con_freed(con);
     free(con->name);
     FREE(con->deco_render_params);
     TAILQ_REMOVE(&all_cons, con, all_cons);
@@ -405,6 +416,8 @@ void tree_split(Con *con, orientation_t orientation) {
         if (con_num_children(con) < 2) {
             DLOG("Just changing orientation of workspace\n");
             con->layout = (orientation == HORIZ) ? L_SPLITH : L_SPLITV;
+            con_invalidate(con);
+            tree_diff_changed(con, TC_LAYOUT);
             return;
         } else {
             /* if there is more than one container on the workspace
@@ -417,6 +430,7 @@ void tree_split(Con *con, orientation_t orientation) {
 
     /* Force re-rendering to make the indicator border visible. */
     con_force_split_parents_redraw(con);
+    con_invalidate(con);
 
     /* if we are in a container whose parent contains only one
      * child (its split functionality is unused so far), we just change the
@@ -425,6 +439,7 @@ void tree_split(Con *con, orientation_t orientation) {
         (parent->layout == L_SPLITH ||
          parent->layout == L_SPLITV)) {
         parent->layout = (orientation == HORIZ) ? L_SPLITH : L_SPLITV;
+        tree_diff_changed(parent, TC_LAYOUT);
         DLOG("Just changing orientation of existing container\n");
         return;
     }
@@ -508,6 +523,28 @@ static void mark_unmapped(Con *con) {
     }
 }
 
+/*
+ * Updates the dirty flags of all workspaces. Before rendering, a dirty root
+ * container is propagated to all workspaces. After rendering, the dirty flag
+ * of all workspaces which were actually rendered in this frame is cleared,
+ * invisible workspaces stay dirty until they are shown.
+ *
+ */
+static void update_dirty_workspaces(bool after_render) {
+    Con *output, *ws;
+    TAILQ_FOREACH(output, &(croot->nodes_head), nodes) {
+        Con *content = output_get_content(output);
+        if (content == NULL)
+            continue;
+        TAILQ_FOREACH(ws, &(content->nodes_head), nodes) {
+            if (!after_render)
+                ws->dirty |= croot->dirty;
+            else if (ws->render_frame == render_stats.frames)
+                ws->dirty = false;
+        }
+    }
+}
+
 /*
  * Renders the tree, that is rendering all outputs using render_con() and
  * pushing the changes to X11 using x_push_changes().
@@ -517,18 +554,78 @@ void tree_render(void) {
     if (croot == NULL)
         return;
 
+    /* This render covers everything which was requested so far. */
+    pending_render = RENDER_NONE;
+
     DLOG("-- BEGIN RENDERING --\n");
+    x_request_stats_start();
+
     /* Reset map state for all nodes in tree */
     /* TODO: a nicer method to walk all nodes would be good, maybe? */
     mark_unmapped(croot);
     croot->mapped = true;
 
+    update_dirty_workspaces(false);
+    croot->dirty = false;
+
+    render_stats.frames++;
+    render_stats.rendered = 0;
+    render_stats.gaps_recomputed = 0;
     render_con(croot, false, false);
+    DLOG("Rendered %u containers, recomputed the gaps of %u of them\n",
+         render_stats.rendered, render_stats.gaps_recomputed);
+
+    update_dirty_workspaces(true);
 
     x_push_changes(croot);
+    x_request_stats_finish();
     DLOG("-- END RENDERING --\n");
 }
 
+/*
+ * Marks the tree as needing a render. The render itself happens once, in
+ * tree_render_pending(), before the event loop blocks again, no matter how
+ * many events of the current batch requested one.
+ *
+ * Code which relies on the X11 state being up to date right away (e.g. before
+ * warping the pointer, during a drag or before replying to a client) has to
+ * call tree_render() directly instead.
+ *
+ */
+void tree_request_render(void) {
+    pending_render = RENDER_FULL;
+}
+
+/*
+ * Like tree_request_render(), but only the changes to already rendered
+ * containers (e.g. a new window title) need to be pushed to X11, see
+ * x_push_changes().
+ *
+ */
+void tree_request_push(void) {
+    if (pending_render == RENDER_NONE)
+        pending_render = RENDER_PUSH;
+}
+
+/*
+ * Performs the render requested by tree_request_render() or
+ * tree_request_push(), if any. Called from the event loop before it blocks.
+ *
+ */
+void tree_render_pending(void) {
+    switch (pending_render) {
+        case RENDER_NONE:
+            break;
+        case RENDER_PUSH:
+            pending_render = RENDER_NONE;
+            x_push_changes(croot);
+            break;
+        case RENDER_FULL:
+            tree_render();
+            break;
+    }
+}
+
 /*
  * Recursive function to walk the tree until a con can be found to focus.
  *
@@ -636,6 +733,7 @@ static bool _tree_next(Con *con, char way, orientation_t orientation, bool wrap)
             TAILQ_REMOVE(&(parent->floating_head), last, floating_windows);
             TAILQ_INSERT_HEAD(&(parent->floating_head), last, floating_windows);
         }
+        tree_diff_changed(parent, TC_FLOATING_NODES);
 
         con_focus(con_descend_focused(next));
         return true;
@@ -0,0 +1,425 @@
+#undef I3__FILE__
+#define I3__FILE__ "tree_diff.c"
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * tree_diff.c: Collects per-container deltas of the layout tree between two
+ *              pushes to X11 and sends them as "tree" IPC events, so that
+ *              clients do not need to poll GET_TREE.
+ *
+ * The places which change a reported property (con_attach(), con_detach(),
+ * the setters in con.c, x_push_node() for rects, …) call tree_diff_changed()
+ * with the container and the properties in question. The containers are
+ * queued with a mask of their changed properties, and once the changes are
+ * pushed to X11, only the queued containers end up in the event, with the
+ * current values of the changed properties. The focus is a single pointer, so
+ * instead of hooking every place which changes it, it is compared once per
+ * push. Nothing is queued while no client is subscribed to the "tree" event.
+ *
+ */
+#include "all.h"
+#include "yajl_utils.h"
+
+#include <inttypes.h>
+#include <yajl/yajl_gen.h>
+
+uint64_t tree_generation = 0;
+
+/* Whether changes are currently being collected. */
+static bool tracking = false;
+
+/* Containers with changes which were not sent yet, in the order in which they
+ * were changed first. See Con.tree_changes. */
+static TAILQ_HEAD(changed_cons_head, Con) changed_cons =
+    TAILQ_HEAD_INITIALIZER(changed_cons);
+
+/* The container which was focused when the last event was sent. */
+static Con *reported_focused = NULL;
+
+/* IDs of the containers which were freed since the last event. */
+static long *removed = NULL;
+static int removed_num = 0;
+static int removed_size = 0;
+
+#define TC_ALL ((1 << 14) - 1)
+
+/*
+ * Returns the name of the container as reported by GET_TREE.
+ *
+ */
+static const char *con_report_name(Con *con) {
+    if (con->window && con->window->name)
+        return i3string_as_utf8(con->window->name);
+    return con->name;
+}
+
+static const char *type_name(Con *con) {
+    switch (con->type) {
+        case CT_ROOT:
+            return "root";
+        case CT_OUTPUT:
+            return "output";
+        case CT_CON:
+            return "con";
+        case CT_FLOATING_CON:
+            return "floating_con";
+        case CT_WORKSPACE:
+            return "workspace";
+        case CT_DOCKAREA:
+            return "dockarea";
+    }
+    return "unknown";
+}
+
+static const char *layout_name(layout_t layout) {
+    switch (layout) {
+        case L_DEFAULT:
+            return "default";
+        case L_SPLITV:
+            return "splitv";
+        case L_SPLITH:
+            return "splith";
+        case L_STACKED:
+            return "stacked";
+        case L_TABBED:
+            return "tabbed";
+        case L_DOCKAREA:
+            return "dockarea";
+        case L_OUTPUT:
+            return "output";
+    }
+    return "unknown";
+}
+
+static const char *border_name(border_style_t border_style) {
+    switch (border_style) {
+        case BS_NORMAL:
+            return "normal";
+        case BS_NONE:
+            return "none";
+        case BS_PIXEL:
+            return "pixel";
+    }
+    return "unknown";
+}
+
+static const char *floating_name(Con *con) {
+    switch (con->floating) {
+        case FLOATING_AUTO_OFF:
+            return "auto_off";
+        case FLOATING_AUTO_ON:
+            return "auto_on";
+        case FLOATING_USER_OFF:
+            return "user_off";
+        case FLOATING_USER_ON:
+            return "user_on";
+    }
+    return "unknown";
+}
+
+/*
+ * Generates the "fields" map of a change, containing the given properties
+ * with their current values. The keys and values are the same as in
+ * GET_TREE, except that children are only referred to by their IDs.
+ *
+ */
+static void dump_fields(yajl_gen gen, Con *con, int fields) {
+    Con *child;
+
+    ystr("fields");
+    y(map_open);
+
+    if (fields & TC_TYPE) {
+        ystr("type");
+        ystr(type_name(con));
+    }
+
+    if (fields & TC_NAME) {
+        const char *name = con_report_name(con);
+        ystr("name");
+        if (name != NULL)
+            ystr(name);
+        else
+            y(null);
+    }
+
+    if (fields & TC_LAYOUT) {
+        ystr("layout");
+        ystr(layout_name(con->layout));
+    }
+
+    if (fields & TC_BORDER) {
+        ystr("border");
+        ystr(border_name(con->border_style));
+    }
+
+    if (fields & TC_RECT) {
+        ystr("rect");
+        y(map_open);
+        ystr("x");
+        y(integer, con->rect.x);
+        ystr("y");
+        y(integer, con->rect.y);
+        ystr("width");
+        y(integer, con->rect.width);
+        ystr("height");
+        y(integer, con->rect.height);
+        y(map_close);
+    }
+
+    if (fields & TC_WINDOW) {
+        ystr("window");
+        if (con->window)
+            y(integer, con->window->id);
+        else
+            y(null);
+    }
+
+    if (fields & TC_URGENT) {
+        ystr("urgent");
+        y(bool, con->urgent);
+    }
+
+    if (fields & TC_FOCUSED) {
+        ystr("focused");
+        y(bool, (con == focused));
+    }
+
+    if (fields & TC_MARK) {
+        ystr("mark");
+        if (con->mark != NULL)
+            ystr(con->mark);
+        else
+            y(null);
+    }
+
+    if (fields & TC_FULLSCREEN) {
+        ystr("fullscreen_mode");
+        y(integer, con->fullscreen_mode);
+    }
+
+    if (fields & TC_FLOATING) {
+        ystr("floating");
+        ystr(floating_name(con));
+    }
+
+    if (fields & TC_NODES) {
+        ystr("nodes");
+        y(array_open);
+        TAILQ_FOREACH(child, &(con->nodes_head), nodes)
+        y(integer, (long int)child);
+        y(array_close);
+    }
+
+    if (fields & TC_FLOATING_NODES) {
+        ystr("floating_nodes");
+        y(array_open);
+        TAILQ_FOREACH(child, &(con->floating_head), floating_windows)
+        y(integer, (long int)child);
+        y(array_close);
+    }
+
+    y(map_close);
+}
+
+static void dump_change(yajl_gen gen, const char *change, Con *con, int fields) {
+    y(map_open);
+    ystr("change");
+    ystr(change);
+    ystr("id");
+    y(integer, (long int)con);
+    if (fields & TC_PARENT) {
+        ystr("parent");
+        if (con->parent != NULL)
+            y(integer, (long int)con->parent);
+        else
+            y(null);
+    }
+    dump_fields(gen, con, fields & ~TC_PARENT);
+    y(map_close);
+}
+
+/*
+ * Records that the given properties (TC_* bits) of the container changed, so
+ * that they are part of the next "tree" event. Containers which were not
+ * reported yet are sent as "added" with all properties instead.
+ *
+ */
+void tree_diff_changed(Con *con, int fields) {
+    if (!tracking || con == NULL)
+        return;
+
+    if (con->tree_changes == 0)
+        TAILQ_INSERT_TAIL(&changed_cons, con, tree_changed);
+    con->tree_changes |= fields;
+}
+
+/*
+ * Removes the container from the queue of changed containers.
+ *
+ */
+static void forget_changes(Con *con) {
+    if (con->tree_changes == 0)
+        return;
+
+    TAILQ_REMOVE(&changed_cons, con, tree_changed);
+    con->tree_changes = 0;
+}
+
+/*
+ * Generates the change of the given queued container. A parent which was not
+ * reported yet is added first, so that clients always know the parent of a
+ * container.
+ *
+ */
+static void dump_queued(yajl_gen gen, Con *con, int *changes) {
+    if (con->parent != NULL && !con->parent->tree_reported &&
+        con->parent->tree_changes != 0)
+        dump_queued(gen, con->parent, changes);
+
+    const int fields = con->tree_changes;
+    forget_changes(con);
+    if (!con->tree_reported) {
+        dump_change(gen, "added", con, TC_ALL);
+        con->tree_reported = true;
+    } else {
+        dump_change(gen, ((fields & TC_PARENT) ? "moved" : "property"), con, fields);
+    }
+    (*changes)++;
+}
+
+/*
+ * Stops collecting changes and forgets about removed containers.
+ *
+ */
+static void tree_diff_stop(void) {
+    while (!TAILQ_EMPTY(&changed_cons))
+        forget_changes(TAILQ_FIRST(&changed_cons));
+
+    FREE(removed);
+    removed_num = 0;
+    removed_size = 0;
+    reported_focused = NULL;
+    tracking = false;
+}
+
+/*
+ * Starts collecting changes. All existing containers count as reported,
+ * clients get them via GET_TREE. Called when the first client subscribes to
+ * the "tree" event.
+ *
+ */
+void tree_diff_start(void) {
+    if (tracking || croot == NULL)
+        return;
+
+    DLOG("Starting to track tree changes\n");
+    Con *con;
+    TAILQ_FOREACH(con, &all_cons, all_cons)
+    con->tree_reported = true;
+    reported_focused = focused;
+    tracking = true;
+}
+
+/*
+ * Sends the changes recorded with tree_diff_changed() since the previous call
+ * as one "tree" event. Called at the end of x_push_changes(). Stops
+ * collecting changes once no client is subscribed anymore.
+ *
+ */
+void tree_diff_push(void) {
+    if (!tracking)
+        return;
+
+    if (!ipc_has_event_subscribers(I3_IPC_EVENT_TREE)) {
+        DLOG("No more subscribers, no longer tracking tree changes\n");
+        tree_diff_stop();
+        return;
+    }
+
+    if (focused != reported_focused) {
+        tree_diff_changed(reported_focused, TC_FOCUSED);
+        tree_diff_changed(focused, TC_FOCUSED);
+        reported_focused = focused;
+    }
+
+    if (TAILQ_EMPTY(&changed_cons) && removed_num == 0)
+        return;
+
+    setlocale(LC_NUMERIC, "C");
+    yajl_gen gen = ygenalloc();
+
+    y(map_open);
+    ystr("changes");
+    y(array_open);
+
+    int changes = 0;
+    for (int i = 0; i < removed_num; i++) {
+        y(map_open);
+        ystr("change");
+        ystr("removed");
+        ystr("id");
+        y(integer, removed[i]);
+        y(map_close);
+        changes++;
+    }
+    removed_num = 0;
+
+    /* Containers which are detached right now (e.g. while being moved) stay
+     * queued until they are attached again or freed. As dump_queued() might
+     * dequeue other containers as well, start over after every change. */
+    Con *con = TAILQ_FIRST(&changed_cons);
+    while (con != TAILQ_END(&changed_cons)) {
+        if (con->parent == NULL && con != croot) {
+            con = TAILQ_NEXT(con, tree_changed);
+            continue;
+        }
+        dump_queued(gen, con, &changes);
+        con = TAILQ_FIRST(&changed_cons);
+    }
+
+    y(array_close);
+
+    if (changes > 0) {
+        ystr("generation");
+        y(integer, ++tree_generation);
+    }
+
+    y(map_close);
+
+    setlocale(LC_NUMERIC, "");
+
+    if (changes > 0) {
+        const unsigned char *payload;
+        ylength length;
+        y(get_buf, &payload, &length);
+
+        DLOG("Sending %d tree changes as generation %" PRIu64 "\n", changes, tree_generation);
+        ipc_send_event("tree", I3_IPC_EVENT_TREE, (const char *)payload);
+    }
+
+    y(free);
+}
+
+/*
+ * Records the removal of the given container. Has to be called before the
+ * container is freed.
+ *
+ */
+void tree_diff_con_freed(Con *con) {
+    forget_changes(con);
+    if (con == reported_focused)
+        reported_focused = NULL;
+
+    if (!tracking || !con->tree_reported)
+        return;
+
+    if (removed_num == removed_size) {
+        removed_size = (removed_size == 0 ? 16 : removed_size * 2);
+        removed = srealloc(removed, removed_size * sizeof(long));
+    }
+    removed[removed_num++] = (long)con;
+}
@@ -320,10 +320,14 @@ static void workspace_reassign_sticky(Con *con) {
         }
 
         x_move_win(src, current);
+        con_index_remove_window(src);
         current->window = src->window;
         current->mapped = true;
         src->window = NULL;
         src->mapped = false;
+        con_index_add_window(current);
+        tree_diff_changed(current, TC_WINDOW | TC_NAME);
+        tree_diff_changed(src, TC_WINDOW | TC_NAME);
 
         x_reparent_child(current, src);
 
@@ -368,6 +372,8 @@ static void _workspace_show(Con *workspace) {
     TAILQ_FOREACH(current, &(workspace->parent->nodes_head), nodes) {
         if (current->fullscreen_mode == CF_OUTPUT)
             old = current;
+        if (current->fullscreen_mode != (current == workspace ? CF_OUTPUT : CF_NONE))
+            tree_diff_changed(current, TC_FULLSCREEN);
         current->fullscreen_mode = CF_NONE;
     }
 
@@ -407,6 +413,7 @@ static void _workspace_show(Con *workspace) {
     if (next->urgent && (int)(config.workspace_urgency_timer * 1000) > 0) {
         /* focus for now… */
         next->urgent = false;
+        tree_diff_changed(next, TC_URGENT);
         con_focus(next);
 
         /* … but immediately reset urgency flags; they will be set to false by
@@ -414,6 +421,8 @@ static void _workspace_show(Con *workspace) {
          * its expiration */
         focused->urgent = true;
         workspace->urgent = true;
+        tree_diff_changed(focused, TC_URGENT);
+        tree_diff_changed(workspace, TC_URGENT);
 
         if (focused->urgency_timer == NULL) {
             DLOG("Deferring reset of urgency flag of con %p on newly shown workspace %p\n",
@@ -444,15 +453,20 @@ static void _workspace_show(Con *workspace) {
         /* check if this workspace is currently visible */
         if (!workspace_is_visible(old)) {
             LOG("Closing old workspace (%p / %s), it is empty\n", old, old->name);
-            yajl_gen gen = ipc_marshal_workspace_event("empty", old, NULL);
+            /* The event has to be generated before the workspace is freed. */
+            yajl_gen gen = NULL;
+            if (ipc_has_event_subscribers(I3_IPC_EVENT_WORKSPACE))
+                gen = ipc_marshal_workspace_event("empty", old, NULL);
             tree_close(old, DONT_KILL_WINDOW, false, false);
 
-            const unsigned char *payload;
-            ylength length;
-            y(get_buf, &payload, &length);
-            ipc_send_event("workspace", I3_IPC_EVENT_WORKSPACE, (const char *)payload);
+            if (gen != NULL) {
+                const unsigned char *payload;
+                ylength length;
+                y(get_buf, &payload, &length);
+                ipc_send_event("workspace", I3_IPC_EVENT_WORKSPACE, (const char *)payload);
 
-            y(free);
+                y(free);
+            }
 
             ewmh_update_number_of_desktops();
             ewmh_update_desktop_names();
@@ -796,8 +810,10 @@ void workspace_update_urgent_flag(Con *ws) {
     ws->urgent = get_urgency_flag(ws);
     DLOG("Workspace urgency flag changed from %d to %d\n", old_flag, ws->urgent);
 
-    if (old_flag != ws->urgent)
+    if (old_flag != ws->urgent) {
+        tree_diff_changed(ws, TC_URGENT);
         ipc_send_workspace_event("urgent", ws, NULL);
+    }
 }
 
 /*
@@ -825,6 +841,7 @@ void ws_force_orientation(Con *ws, orientation_t orientation) {
 
     /* 4: switch workspace layout */
     ws->layout = (orientation == HORIZ) ? L_SPLITH : L_SPLITV;
+    tree_diff_changed(ws, TC_LAYOUT);
     DLOG("split->layout = %d, ws->layout = %d\n", split->layout, ws->layout);
 
     /* 5: attach the new split container to the workspace */
@@ -15,6 +15,23 @@
 /* Stores the X11 window ID of the currently focused window */
 xcb_window_t focused_id = XCB_NONE;
 
+struct x_request_stats x_request_stats;
+
+/* Wall time at which the current render started, 0 outside of renders. */
+static ev_tstamp render_started;
+
+/* Count the requests this file sends, see x_request_stats. A function-like
+ * macro is not expanded again within its own replacement, so the inner call
+ * refers to the actual xcb function. */
+#define COUNT_REQUEST(type) (x_request_stats.current[(type)]++)
+#define xcb_configure_window(...) (COUNT_REQUEST(XR_CONFIGURE_WINDOW), xcb_configure_window(__VA_ARGS__))
+#define xcb_set_window_rect(...) (COUNT_REQUEST(XR_CONFIGURE_WINDOW), xcb_set_window_rect(__VA_ARGS__))
+#define xcb_change_window_attributes(...) (COUNT_REQUEST(XR_CHANGE_WINDOW_ATTRIBUTES), xcb_change_window_attributes(__VA_ARGS__))
+#define xcb_copy_area(...) (COUNT_REQUEST(XR_COPY_AREA), xcb_copy_area(__VA_ARGS__))
+#define xcb_map_window(...) (COUNT_REQUEST(XR_MAP_WINDOW), xcb_map_window(__VA_ARGS__))
+#define xcb_unmap_window(...) (COUNT_REQUEST(XR_UNMAP_WINDOW), xcb_unmap_window(__VA_ARGS__))
+#define xcb_poly_fill_rectangle(...) (COUNT_REQUEST(XR_POLY_FILL_RECTANGLE), xcb_poly_fill_rectangle(__VA_ARGS__))
+
 /* Because 'focused_id' might be reset to force input focus, we separately keep
  * track of the X11 window ID to be able to always tell whether the focused
  * window actually changed. */
@@ -49,16 +66,51 @@ typedef struct con_state {
 
     Rect rect;
     Rect window_rect;
+    /* con->rect as of the last push, for the "tree" event */
+    Rect con_rect;
 
     bool initial;
 
     char *name;
 
+    /* Number of requests counted for this container during the render with
+     * the number requests_render (see x_request_stats). */
+    uint32_t requests;
+    uint64_t requests_render;
+
     CIRCLEQ_ENTRY(con_state) state;
     CIRCLEQ_ENTRY(con_state) old_state;
     TAILQ_ENTRY(con_state) initial_mapping_order;
 } con_state;
 
+/*
+ * The title bar of a container, rendered into a pixmap of its own and copied
+ * onto the pixmap of the parent by x_draw_decoration(). It is only rendered
+ * again when the parameters or the text change. As the text is clipped to
+ * this pixmap, it cannot spill into the title bar of the next sibling, so
+ * changing one tab does not require redrawing all tabs to its right.
+ *
+ */
+struct deco_strip_params {
+    struct Colortriple color;
+    uint32_t width;
+    uint32_t height;
+    layout_t parent_layout;
+    int deco_diff_l;
+    int deco_diff_r;
+    int indent_px;
+};
+
+struct deco_strip {
+    xcb_pixmap_t pixmap;
+    text_renderer *renderer;
+
+    /* What the pixmap currently contains. */
+    struct deco_strip_params params;
+    char *title;
+    char *mark;
+};
+
 CIRCLEQ_HEAD(state_head, con_state) state_head =
     CIRCLEQ_HEAD_INITIALIZER(state_head);
 
@@ -69,16 +121,19 @@ TAILQ_HEAD(initial_mapping_head, con_state) initial_mapping_head =
     TAILQ_HEAD_INITIALIZER(initial_mapping_head);
 
 /*
- * Returns the container state for the given frame. This function always
- * returns a container state (otherwise, there is a bug in the code and the
- * container state of a container for which x_con_init() was not called was
- * requested).
+ * Returns the container state for the frame of the given container. This
+ * function always returns a container state (otherwise, there is a bug in the
+ * code and the container state of a container for which x_con_init() was not
+ * called was requested).
+ *
+ * The state is stored in the container itself instead of being searched in
+ * state_head, because x_push_node() and x_raise_con() need it for every
+ * container in every frame.
  *
  */
-static con_state *state_for_frame(xcb_window_t window) {
-    con_state *state;
-    CIRCLEQ_FOREACH(state, &state_head, state)
-    if (state->id == window)
+static con_state *state_for_con(Con *con) {
+    con_state *state = con->state;
+    if (state != NULL && state->id == con->frame)
         return state;
 
     /* TODO: better error handling? */
@@ -87,6 +142,41 @@ static con_state *state_for_frame(xcb_window_t window) {
     return NULL;
 }
 
+/*
+ * Returns the number of requests counted since the start of the current
+ * render.
+ *
+ */
+static uint32_t requests_sent(void) {
+    uint32_t sent = 0;
+    for (int type = 0; type < XR_NUM_TYPES; type++)
+        sent += x_request_stats.current[type];
+    return sent;
+}
+
+/*
+ * Attributes the requests sent since 'before' to the container of the given
+ * state and keeps track of the container with the most requests in the
+ * current render.
+ *
+ */
+static void attribute_requests(con_state *state, uint32_t before) {
+    uint32_t sent = requests_sent() - before;
+    if (sent == 0 || render_started == 0)
+        return;
+
+    if (state->requests_render != x_request_stats.renders) {
+        state->requests_render = x_request_stats.renders;
+        state->requests = 0;
+    }
+    state->requests += sent;
+
+    if (state->requests > x_request_stats.heaviest_requests) {
+        x_request_stats.heaviest = state->con;
+        x_request_stats.heaviest_requests = state->requests;
+    }
+}
+
 /*
  * Initializes the X11 part for the given container. Called exactly once for
  * every container from con_new().
@@ -147,10 +237,13 @@ void x_con_init(Con *con, uint16_t depth) {
     if (win_colormap != XCB_NONE)
         xcb_free_colormap(conn, win_colormap);
 
+    con_index_add_frame(con);
+
     struct con_state *state = scalloc(sizeof(struct con_state));
     state->id = con->frame;
     state->mapped = false;
     state->initial = true;
+    con->state = state;
     DLOG("Adding window 0x%08x to lists\n", state->id);
     CIRCLEQ_INSERT_HEAD(&state_head, state, state);
     CIRCLEQ_INSERT_HEAD(&old_state_head, state, old_state);
@@ -167,7 +260,7 @@ void x_con_init(Con *con, uint16_t depth) {
 void x_reinit(Con *con) {
     struct con_state *state;
 
-    if ((state = state_for_frame(con->frame)) == NULL) {
+    if ((state = state_for_con(con)) == NULL) {
         ELOG("window state not found\n");
         return;
     }
@@ -186,7 +279,7 @@ void x_reinit(Con *con) {
  */
 void x_reparent_child(Con *con, Con *old) {
     struct con_state *state;
-    if ((state = state_for_frame(con->frame)) == NULL) {
+    if ((state = state_for_con(con)) == NULL) {
         ELOG("window state for con not found\n");
         return;
     }
@@ -202,12 +295,12 @@ void x_reparent_child(Con *con, Con *old) {
 void x_move_win(Con *src, Con *dest) {
     struct con_state *state_src, *state_dest;
 
-    if ((state_src = state_for_frame(src->frame)) == NULL) {
+    if ((state_src = state_for_con(src)) == NULL) {
         ELOG("window state for src not found\n");
         return;
     }
 
-    if ((state_dest = state_for_frame(dest->frame)) == NULL) {
+    if ((state_dest = state_for_con(dest)) == NULL) {
         ELOG("window state for dest not found\n");
         return;
     }
@@ -222,6 +315,37 @@ void x_move_win(Con *src, Con *dest) {
     }
 }
 
+/*
+ * Frees the pre-rendered title bar of the given container.
+ *
+ */
+static void deco_strip_free(Con *con) {
+    struct deco_strip *strip = con->deco_strip;
+    if (strip == NULL)
+        return;
+
+    if (strip->pixmap != XCB_NONE) {
+        text_renderer_free(strip->renderer);
+        xcb_free_pixmap(conn, strip->pixmap);
+    }
+    FREE(strip->title);
+    FREE(strip->mark);
+    FREE(con->deco_strip);
+}
+
+/*
+ * Frees the pre-rendered title bars of all containers, so that they are
+ * rendered again. Called when reloading the config, since the font is not
+ * part of struct deco_strip_params.
+ *
+ */
+void x_invalidate_deco_strips(void) {
+    Con *con;
+    TAILQ_FOREACH(con, &all_cons, all_cons) {
+        deco_strip_free(con);
+    }
+}
+
 /*
  * Kills the window decoration associated with the given container.
  *
@@ -229,30 +353,33 @@ void x_move_win(Con *src, Con *dest) {
 void x_con_kill(Con *con) {
     con_state *state;
 
+    con_index_remove_frame(con);
     xcb_destroy_window(conn, con->frame);
+    deco_strip_free(con);
     xcb_free_pixmap(conn, con->pixmap);
     xcb_free_gc(conn, con->pm_gc);
-    state = state_for_frame(con->frame);
+    state = state_for_con(con);
     CIRCLEQ_REMOVE(&state_head, state, state);
     CIRCLEQ_REMOVE(&old_state_head, state, old_state);
     TAILQ_REMOVE(&initial_mapping_head, state, initial_mapping_order);
     FREE(state->name);
     free(state);
+    con->state = NULL;
 
     /* Invalidate focused_id to correctly focus new windows with the same ID */
     focused_id = last_focused = XCB_NONE;
 }
 
 /*
- * Returns true if the client supports the given protocol atom (like WM_DELETE_WINDOW)
+ * Returns true if the WM_PROTOCOLS reply for the given cookie contains the
+ * given protocol atom. Used when the request was sent earlier, see
+ * manage_window().
  *
  */
-bool window_supports_protocol(xcb_window_t window, xcb_atom_t atom) {
-    xcb_get_property_cookie_t cookie;
+bool window_protocols_contain(xcb_get_property_cookie_t cookie, xcb_atom_t atom) {
     xcb_icccm_get_wm_protocols_reply_t protocols;
     bool result = false;
 
-    cookie = xcb_icccm_get_wm_protocols(conn, window, A_WM_PROTOCOLS);
     if (xcb_icccm_get_wm_protocols_reply(conn, cookie, &protocols, NULL) != 1)
         return false;
 
@@ -266,6 +393,14 @@ bool window_supports_protocol(xcb_window_t window, xcb_atom_t atom) {
     return result;
 }
 
+/*
+ * Returns true if the client supports the given protocol atom (like WM_DELETE_WINDOW)
+ *
+ */
+bool window_supports_protocol(xcb_window_t window, xcb_atom_t atom) {
+    return window_protocols_contain(xcb_icccm_get_wm_protocols(conn, window, A_WM_PROTOCOLS), atom);
+}
+
 /*
  * Kills the given X11 window using WM_DELETE_WINDOW (if supported).
  *
@@ -341,6 +476,172 @@ static i3String *parse_title_format(char *format, i3String *_title) {
     return formatted;
 }
 
+/*
+ * Renders the title bar of the given container into its deco_strip, unless
+ * the strip already shows the same text with the same parameters.
+ *
+ */
+static void x_render_deco_strip(Con *con, struct Colortriple *color) {
+    Con *parent = con->parent;
+    struct Window *win = con->window;
+
+    struct deco_strip_params params;
+    memset(&params, 0, sizeof(struct deco_strip_params));
+    params.color = *color;
+    params.width = con->deco_rect.width;
+    params.height = con->deco_rect.height;
+    params.parent_layout = parent->layout;
+
+    adjacent_t borders_to_hide = con_adjacent_borders(con) & config.hide_edge_borders;
+    params.deco_diff_l = borders_to_hide & ADJ_LEFT_SCREEN_EDGE ? 0 : con->current_border_width;
+    params.deco_diff_r = borders_to_hide & ADJ_RIGHT_SCREEN_EDGE ? 0 : con->current_border_width;
+    if (parent->layout == L_TABBED ||
+        (parent->layout == L_STACKED && TAILQ_NEXT(con, nodes) != NULL)) {
+        params.deco_diff_l = 0;
+        params.deco_diff_r = 0;
+    }
+
+    int indent_level = 0,
+        indent_mult = 0;
+    Con *il_parent = parent;
+    if (win != NULL && il_parent->layout != L_STACKED) {
+        while (1) {
+            //DLOG("il_parent = %p, layout = %d\n", il_parent, il_parent->layout);
+            if (il_parent->layout == L_STACKED)
+                indent_level++;
+            if (il_parent->type == CT_WORKSPACE || il_parent->type == CT_DOCKAREA || il_parent->type == CT_OUTPUT)
+                break;
+            il_parent = il_parent->parent;
+            indent_mult++;
+        }
+    }
+    //DLOG("indent_level = %d, indent_mult = %d\n", indent_level, indent_mult);
+    params.indent_px = (indent_level * 5) * indent_mult;
+
+    /* Split containers get a representation of their children as title.
+     * Windows without a name get no title at all. */
+    char *title = NULL;
+    i3String *win_title = NULL;
+    if (win == NULL) {
+        char *tree = con_get_tree_representation(con);
+        sasprintf(&title, "i3: %s", tree);
+        free(tree);
+    } else if (win->name != NULL) {
+        win_title = (win->title_format == NULL ? win->name : parse_title_format(win->title_format, win->name));
+        title = sstrdup(i3string_as_utf8(win_title));
+    }
+
+    char *mark = NULL;
+    if (win_title != NULL && config.show_marks && con->mark != NULL && (con->mark)[0] != '_')
+        sasprintf(&mark, "[%s]", con->mark);
+
+    struct deco_strip *strip = con->deco_strip;
+    if (strip != NULL &&
+        memcmp(&(strip->params), &params, sizeof(struct deco_strip_params)) == 0 &&
+        (strip->title == NULL ? title == NULL : title != NULL && strcmp(strip->title, title) == 0) &&
+        (strip->mark == NULL ? mark == NULL : mark != NULL && strcmp(strip->mark, mark) == 0)) {
+        free(title);
+        free(mark);
+        if (win_title != NULL && win->title_format != NULL)
+            I3STRING_FREE(win_title);
+        return;
+    }
+
+    if (strip == NULL)
+        strip = con->deco_strip = scalloc(sizeof(struct deco_strip));
+
+    if (strip->pixmap == XCB_NONE ||
+        strip->params.width != params.width ||
+        strip->params.height != params.height) {
+        if (strip->pixmap != XCB_NONE) {
+            text_renderer_free(strip->renderer);
+            xcb_free_pixmap(conn, strip->pixmap);
+        }
+        /* The strip is copied onto the pixmap of the parent, which never
+         * has a window and therefore uses the root depth. */
+        strip->pixmap = xcb_generate_id(conn);
+        xcb_create_pixmap(conn, root_depth, strip->pixmap, root, params.width, params.height);
+        strip->renderer = text_renderer_new(strip->pixmap, params.width, params.height);
+    }
+
+    strip->params = params;
+    FREE(strip->title);
+    FREE(strip->mark);
+    strip->title = title;
+    strip->mark = mark;
+
+    const int width = params.width;
+    const int height = params.height;
+    xcb_gcontext_t gc = parent->pm_gc;
+
+    /* paint the bar */
+    xcb_change_gc(conn, gc, XCB_GC_FOREGROUND, (uint32_t[]){color->background});
+    xcb_rectangle_t drect = {0, 0, width, height};
+    xcb_poly_fill_rectangle(conn, strip->pixmap, gc, 1, &drect);
+
+    /* draw two unconnected horizontal lines in border color */
+    xcb_change_gc(conn, gc, XCB_GC_FOREGROUND, (uint32_t[]){color->border});
+    xcb_segment_t segments[] = {
+        {0, 0,
+         width - 1, 0},
+        {params.deco_diff_l, height - 1,
+         width - params.deco_diff_r - 1, height - 1}};
+    xcb_poly_segment(conn, strip->pixmap, gc, 2, segments);
+
+    /* draw the title */
+    if (title == NULL)
+        return;
+
+    set_font_colors(gc, color->text, color->background);
+    int text_offset_y = (height - config.font.height) / 2;
+
+    if (win == NULL) {
+        draw_text_ascii(title, strip->pixmap, gc, 2, text_offset_y, width - 2);
+    } else {
+        int mark_width = 0;
+        if (mark != NULL) {
+            i3String *mark_str = i3string_from_utf8(mark);
+            mark_width = predict_text_width(mark_str);
+
+            text_renderer_draw(strip->renderer, mark_str, gc,
+                               width - mark_width - logical_px(2),
+                               text_offset_y, mark_width);
+
+            I3STRING_FREE(mark_str);
+        }
+
+        text_renderer_draw(strip->renderer, win_title, gc,
+                           logical_px(2) + params.indent_px, text_offset_y,
+                           width - logical_px(2) - params.indent_px - mark_width - logical_px(2));
+        if (win->title_format != NULL)
+            I3STRING_FREE(win_title);
+    }
+
+    /* The text might in some cases be painted on the border pixels on the
+     * right side of the title bar. Therefore, we draw the right border again
+     * after rendering the text (and the unconnected lines in border color). */
+
+    /* Draw a 1px separator line before and after every tab, so that tabs can
+     * be easily distinguished. */
+    if (parent->layout == L_TABBED) {
+        xcb_change_gc(conn, gc, XCB_GC_FOREGROUND, (uint32_t[]){color->border});
+    } else {
+        xcb_change_gc(conn, gc, XCB_GC_FOREGROUND, (uint32_t[]){color->background});
+    }
+    xcb_poly_line(conn, XCB_COORD_MODE_ORIGIN, strip->pixmap, gc, 6,
+                  (xcb_point_t[]){
+                      {width, 0},
+                      {width, height},
+                      {width - 1, 0},
+                      {width - 1, height},
+                      {0, height},
+                      {0, 0},
+                  });
+
+    xcb_change_gc(conn, gc, XCB_GC_FOREGROUND, (uint32_t[]){color->border});
+    xcb_poly_segment(conn, strip->pixmap, gc, 2, segments);
+}
+
 /*
  * Draws the decoration of the given container onto its parent.
  *
@@ -409,11 +710,6 @@ void x_draw_decoration(Con *con) {
         goto copy_pixmaps;
     }
 
-    Con *next = con;
-    while ((next = TAILQ_NEXT(next, nodes))) {
-        FREE(next->deco_render_params);
-    }
-
     FREE(con->deco_render_params);
     con->deco_render_params = p;
 
@@ -503,124 +799,18 @@ void x_draw_decoration(Con *con) {
     }
 
     /* if this is a borderless/1pixel window, we don’t need to render the
-     * decoration. */
-    if (p->border_style != BS_NORMAL)
+     * decoration. The same goes for decorations whose parent has not been
+     * pushed yet (it has no pixmap to draw onto). */
+    if (p->border_style != BS_NORMAL ||
+        parent->pixmap == XCB_NONE ||
+        con->deco_rect.width == 0 ||
+        con->deco_rect.height == 0)
         goto copy_pixmaps;
 
-    /* 4: paint the bar */
-    xcb_change_gc(conn, parent->pm_gc, XCB_GC_FOREGROUND, (uint32_t[]){p->color->background});
-    xcb_rectangle_t drect = {con->deco_rect.x, con->deco_rect.y, con->deco_rect.width, con->deco_rect.height};
-    xcb_poly_fill_rectangle(conn, parent->pixmap, parent->pm_gc, 1, &drect);
-
-    /* 5: draw two unconnected horizontal lines in border color */
-    xcb_change_gc(conn, parent->pm_gc, XCB_GC_FOREGROUND, (uint32_t[]){p->color->border});
-    Rect *dr = &(con->deco_rect);
-    adjacent_t borders_to_hide = con_adjacent_borders(con) & config.hide_edge_borders;
-    int deco_diff_l = borders_to_hide & ADJ_LEFT_SCREEN_EDGE ? 0 : con->current_border_width;
-    int deco_diff_r = borders_to_hide & ADJ_RIGHT_SCREEN_EDGE ? 0 : con->current_border_width;
-    if (parent->layout == L_TABBED ||
-        (parent->layout == L_STACKED && TAILQ_NEXT(con, nodes) != NULL)) {
-        deco_diff_l = 0;
-        deco_diff_r = 0;
-    }
-    xcb_segment_t segments[] = {
-        {dr->x, dr->y,
-         dr->x + dr->width - 1, dr->y},
-        {dr->x + deco_diff_l, dr->y + dr->height - 1,
-         dr->x - deco_diff_r + dr->width - 1, dr->y + dr->height - 1}};
-    xcb_poly_segment(conn, parent->pixmap, parent->pm_gc, 2, segments);
-
-    /* 6: draw the title */
-    set_font_colors(parent->pm_gc, p->color->text, p->color->background);
-    int text_offset_y = (con->deco_rect.height - config.font.height) / 2;
-
-    struct Window *win = con->window;
-    if (win == NULL) {
-        /* we have a split container which gets a representation
-         * of its children as title
-         */
-        char *title;
-        char *tree = con_get_tree_representation(con);
-        sasprintf(&title, "i3: %s", tree);
-        free(tree);
-
-        draw_text_ascii(title,
-                        parent->pixmap, parent->pm_gc,
-                        con->deco_rect.x + 2, con->deco_rect.y + text_offset_y,
-                        con->deco_rect.width - 2);
-        free(title);
-
-        goto after_title;
-    }
-
-    if (win->name == NULL)
-        goto copy_pixmaps;
-
-    int indent_level = 0,
-        indent_mult = 0;
-    Con *il_parent = parent;
-    if (il_parent->layout != L_STACKED) {
-        while (1) {
-            //DLOG("il_parent = %p, layout = %d\n", il_parent, il_parent->layout);
-            if (il_parent->layout == L_STACKED)
-                indent_level++;
-            if (il_parent->type == CT_WORKSPACE || il_parent->type == CT_DOCKAREA || il_parent->type == CT_OUTPUT)
-                break;
-            il_parent = il_parent->parent;
-            indent_mult++;
-        }
-    }
-    //DLOG("indent_level = %d, indent_mult = %d\n", indent_level, indent_mult);
-    int indent_px = (indent_level * 5) * indent_mult;
-
-    int mark_width = 0;
-    if (config.show_marks && con->mark != NULL && (con->mark)[0] != '_') {
-        char *formatted_mark;
-        sasprintf(&formatted_mark, "[%s]", con->mark);
-        i3String *mark = i3string_from_utf8(formatted_mark);
-        FREE(formatted_mark);
-        mark_width = predict_text_width(mark);
-
-        draw_text(mark, parent->pixmap, parent->pm_gc,
-                  con->deco_rect.x + con->deco_rect.width - mark_width - logical_px(2),
-                  con->deco_rect.y + text_offset_y, mark_width);
-
-        I3STRING_FREE(mark);
-    }
-
-    i3String *title = win->title_format == NULL ? win->name : parse_title_format(win->title_format, win->name);
-    draw_text(title,
-              parent->pixmap, parent->pm_gc,
-              con->deco_rect.x + logical_px(2) + indent_px, con->deco_rect.y + text_offset_y,
-              con->deco_rect.width - logical_px(2) - indent_px - mark_width - logical_px(2));
-    if (win->title_format != NULL)
-        I3STRING_FREE(title);
-
-after_title:
-    /* Since we don’t clip the text at all, it might in some cases be painted
-     * on the border pixels on the right side of a window. Therefore, we draw
-     * the right border again after rendering the text (and the unconnected
-     * lines in border color). */
-
-    /* Draw a 1px separator line before and after every tab, so that tabs can
-     * be easily distinguished. */
-    if (parent->layout == L_TABBED) {
-        xcb_change_gc(conn, parent->pm_gc, XCB_GC_FOREGROUND, (uint32_t[]){p->color->border});
-    } else {
-        xcb_change_gc(conn, parent->pm_gc, XCB_GC_FOREGROUND, (uint32_t[]){p->color->background});
-    }
-    xcb_poly_line(conn, XCB_COORD_MODE_ORIGIN, parent->pixmap, parent->pm_gc, 6,
-                  (xcb_point_t[]){
-                      {dr->x + dr->width, dr->y},
-                      {dr->x + dr->width, dr->y + dr->height},
-                      {dr->x + dr->width - 1, dr->y},
-                      {dr->x + dr->width - 1, dr->y + dr->height},
-                      {dr->x, dr->y + dr->height},
-                      {dr->x, dr->y},
-                  });
-
-    xcb_change_gc(conn, parent->pm_gc, XCB_GC_FOREGROUND, (uint32_t[]){p->color->border});
-    xcb_poly_segment(conn, parent->pixmap, parent->pm_gc, 2, segments);
+    /* 4: render the title bar (if it changed) and copy it onto the parent */
+    x_render_deco_strip(con, p->color);
+    xcb_copy_area(conn, con->deco_strip->pixmap, parent->pixmap, parent->pm_gc, 0, 0,
+                  con->deco_rect.x, con->deco_rect.y, con->deco_rect.width, con->deco_rect.height);
 
 copy_pixmaps:
     xcb_copy_area(conn, con->pixmap, con->frame, con->pm_gc, 0, 0, 0, 0, con->rect.width, con->rect.height);
@@ -636,7 +826,7 @@ void x_deco_recurse(Con *con) {
     Con *current;
     bool leaf = TAILQ_EMPTY(&(con->nodes_head)) &&
                 TAILQ_EMPTY(&(con->floating_head));
-    con_state *state = state_for_frame(con->frame);
+    con_state *state = state_for_con(con);
 
     if (!leaf) {
         TAILQ_FOREACH(current, &(con->nodes_head), nodes)
@@ -644,14 +834,16 @@ void x_deco_recurse(Con *con) {
 
         TAILQ_FOREACH(current, &(con->floating_head), floating_windows)
         x_deco_recurse(current);
-
-        if (state->mapped)
-            xcb_copy_area(conn, con->pixmap, con->frame, con->pm_gc, 0, 0, 0, 0, con->rect.width, con->rect.height);
     }
 
+    const uint32_t before = requests_sent();
+    if (!leaf && state->mapped)
+        xcb_copy_area(conn, con->pixmap, con->frame, con->pm_gc, 0, 0, 0, 0, con->rect.width, con->rect.height);
+
     if ((con->type != CT_ROOT && con->type != CT_OUTPUT) &&
         (!leaf || con->mapped))
         x_draw_decoration(con);
+    attribute_requests(state, before);
 }
 
 /*
@@ -663,7 +855,7 @@ static void set_hidden_state(Con *con) {
         return;
     }
 
-    con_state *state = state_for_frame(con->frame);
+    con_state *state = state_for_con(con);
     bool should_be_hidden = con_is_hidden(con);
     if (should_be_hidden == state->is_hidden)
         return;
@@ -681,6 +873,32 @@ static void set_hidden_state(Con *con) {
     state->is_hidden = should_be_hidden;
 }
 
+/*
+ * Returns the rect which x_push_node() will set on the frame of the given
+ * container. Frames of split containers only cover the window decorations of
+ * their children.
+ *
+ */
+static Rect x_frame_rect(Con *con) {
+    Rect rect = con->rect;
+    if (con->window != NULL)
+        return rect;
+
+    /* Calculate the height of all window decorations which will be drawn on to
+     * this frame. */
+    uint32_t max_y = 0, max_height = 0;
+    Con *current;
+    TAILQ_FOREACH(current, &(con->nodes_head), nodes) {
+        Rect *dr = &(current->deco_rect);
+        if (dr->y >= max_y && dr->height >= max_height) {
+            max_y = dr->y;
+            max_height = dr->height;
+        }
+    }
+    rect.height = max_y + max_height;
+    return rect;
+}
+
 /*
  * This function pushes the properties of each node of the layout tree to
  * X11 if they have changed (like the map state, position of the window, …).
@@ -690,10 +908,16 @@ static void set_hidden_state(Con *con) {
 void x_push_node(Con *con) {
     Con *current;
     con_state *state;
-    Rect rect = con->rect;
+    Rect rect = x_frame_rect(con);
 
     //DLOG("Pushing changes for node %p / %s\n", con, con->name);
-    state = state_for_frame(con->frame);
+    state = state_for_con(con);
+    const uint32_t before = requests_sent();
+
+    if (memcmp(&(state->con_rect), &(con->rect), sizeof(Rect)) != 0) {
+        memcpy(&(state->con_rect), &(con->rect), sizeof(Rect));
+        tree_diff_changed(con, TC_RECT);
+    }
 
     if (state->name != NULL) {
         DLOG("pushing name %s for con %p\n", state->name, con);
@@ -703,21 +927,8 @@ void x_push_node(Con *con) {
         FREE(state->name);
     }
 
-    if (con->window == NULL) {
-        /* Calculate the height of all window decorations which will be drawn on to
-         * this frame. */
-        uint32_t max_y = 0, max_height = 0;
-        TAILQ_FOREACH(current, &(con->nodes_head), nodes) {
-            Rect *dr = &(current->deco_rect);
-            if (dr->y >= max_y && dr->height >= max_height) {
-                max_y = dr->y;
-                max_height = dr->height;
-            }
-        }
-        rect.height = max_y + max_height;
-        if (rect.height == 0)
-            con->mapped = false;
-    }
+    if (con->window == NULL && rect.height == 0)
+        con->mapped = false;
 
     /* reparent the child window (when the window was moved due to a sticky
      * container) */
@@ -885,6 +1096,7 @@ void x_push_node(Con *con) {
     }
 
     set_hidden_state(con);
+    attribute_requests(state, before);
 
     /* Handle all children and floating windows of this node. We recurse
      * in focus order to display the focused client in a stack first when
@@ -907,7 +1119,7 @@ static void x_push_node_unmaps(Con *con) {
     con_state *state;
 
     //DLOG("Pushing changes (with unmaps) for node %p / %s\n", con, con->name);
-    state = state_for_frame(con->frame);
+    state = state_for_con(con);
 
     /* map/unmap if map state changed, also ensure that the child window
      * is changed if we are mapped *and* in initial state (meaning the
@@ -959,6 +1171,41 @@ static bool is_con_attached(Con *con) {
     return false;
 }
 
+/*
+ * Returns true if x_push_node() will map, move, resize or restack any window or
+ * reparent a client window, i.e. if pushing the changes can generate
+ * EnterNotify events. Unmaps are not considered, they are handled separately
+ * at the end of x_push_changes().
+ *
+ */
+static bool x_enter_notify_possible(void) {
+    if (warp_to)
+        return true;
+
+    con_state *state;
+    CIRCLEQ_FOREACH_REVERSE(state, &state_head, state) {
+        if (state->initial || CIRCLEQ_PREV(state, state) != CIRCLEQ_PREV(state, old_state))
+            return true;
+
+        Con *con = state->con;
+        if (con->window != NULL &&
+            (state->need_reparent ||
+             (con->mapped && !state->child_mapped) ||
+             memcmp(&(state->window_rect), &(con->window_rect), sizeof(Rect)) != 0))
+            return true;
+
+        Rect rect = x_frame_rect(con);
+        if (rect.height == 0)
+            continue;
+
+        if ((con->mapped && !state->mapped) ||
+            memcmp(&(state->rect), &rect, sizeof(Rect)) != 0)
+            return true;
+    }
+
+    return false;
+}
+
 /*
  * Pushes all changes (state of each node, see x_push_node() and the window
  * stack) to X11.
@@ -980,13 +1227,23 @@ void x_push_changes(Con *con) {
     }
 
     DLOG("-- PUSHING WINDOW STACK --\n");
-    //DLOG("Disabling EnterNotify\n");
+    /* Number of event mask changes sent to avoid EnterNotify events. */
+    unsigned int mask_requests = 0;
+
+    /* Mapping, moving or restacking windows generates EnterNotify events for
+     * the window which ends up under the pointer, which can be any mapped
+     * frame. When none of that happens (e.g. a title or focus change), there
+     * is no need to touch the event masks at all. */
+    const bool disable_enter = x_enter_notify_possible();
     uint32_t values[1] = {XCB_NONE};
-    CIRCLEQ_FOREACH_REVERSE(state, &state_head, state) {
-        if (state->mapped)
+    if (disable_enter) {
+        CIRCLEQ_FOREACH_REVERSE(state, &state_head, state) {
+            if (!state->mapped)
+                continue;
             xcb_change_window_attributes(conn, state->id, XCB_CW_EVENT_MASK, values);
+            mask_requests++;
+        }
     }
-    //DLOG("Done, EnterNotify disabled\n");
     bool order_changed = false;
     bool stacking_changed = false;
 
@@ -1072,13 +1329,15 @@ void x_push_changes(Con *con) {
         warp_to = NULL;
     }
 
-    //DLOG("Re-enabling EnterNotify\n");
-    values[0] = FRAME_EVENT_MASK;
-    CIRCLEQ_FOREACH_REVERSE(state, &state_head, state) {
-        if (state->mapped)
+    if (disable_enter) {
+        values[0] = FRAME_EVENT_MASK;
+        CIRCLEQ_FOREACH_REVERSE(state, &state_head, state) {
+            if (!state->mapped)
+                continue;
             xcb_change_window_attributes(conn, state->id, XCB_CW_EVENT_MASK, values);
+            mask_requests++;
+        }
     }
-    //DLOG("Done, EnterNotify re-enabled\n");
 
     x_deco_recurse(con);
 
@@ -1150,6 +1409,7 @@ void x_push_changes(Con *con) {
         if (!state->unmap_now)
             continue;
         xcb_change_window_attributes(conn, state->id, XCB_CW_EVENT_MASK, values);
+        mask_requests++;
     }
 
     /* Push all pending unmaps */
@@ -1165,6 +1425,13 @@ void x_push_changes(Con *con) {
     //}
 
     xcb_flush(conn);
+    DLOG("Sent %u event mask changes to suppress EnterNotify (%s)\n",
+         mask_requests, (disable_enter ? "windows changed" : "no window changed"));
+
+    /* Tell IPC clients which containers changed now that the changes are
+     * visible. This is done here instead of in tree_render() because title
+     * and focus changes are pushed without rendering the tree. */
+    tree_diff_push();
 }
 
 /*
@@ -1174,7 +1441,7 @@ void x_push_changes(Con *con) {
  */
 void x_raise_con(Con *con) {
     con_state *state;
-    state = state_for_frame(con->frame);
+    state = state_for_con(con);
     //DLOG("raising in new stack: %p / %s / %s / xid %08x\n", con, con->name, con->window ? con->window->name_json : "", state->id);
 
     CIRCLEQ_REMOVE(&state_head, state, state);
@@ -1190,7 +1457,7 @@ void x_raise_con(Con *con) {
 void x_set_name(Con *con, const char *name) {
     struct con_state *state;
 
-    if ((state = state_for_frame(con->frame)) == NULL) {
+    if ((state = state_for_con(con)) == NULL) {
         ELOG("window state not found\n");
         return;
     }
@@ -1249,3 +1516,69 @@ void x_mask_event_mask(uint32_t mask) {
             xcb_change_window_attributes(conn, state->id, XCB_CW_EVENT_MASK, values);
     }
 }
+
+/*
+ * Returns the name of the given request type, as used in the GET_X_STATS
+ * reply.
+ *
+ */
+const char *x_request_name(x_request_t type) {
+    static const char *names[XR_NUM_TYPES] = {
+        [XR_CONFIGURE_WINDOW] = "configure_window",
+        [XR_CHANGE_WINDOW_ATTRIBUTES] = "change_window_attributes",
+        [XR_COPY_AREA] = "copy_area",
+        [XR_MAP_WINDOW] = "map_window",
+        [XR_UNMAP_WINDOW] = "unmap_window",
+        [XR_POLY_FILL_RECTANGLE] = "poly_fill_rectangle"};
+    return names[type];
+}
+
+/*
+ * Starts recording the requests of a render. Requests which were sent since
+ * the last render (e.g. because a window title changed) only count towards
+ * the totals.
+ *
+ */
+void x_request_stats_start(void) {
+    for (int type = 0; type < XR_NUM_TYPES; type++) {
+        x_request_stats.total[type] += x_request_stats.current[type];
+        x_request_stats.current[type] = 0;
+    }
+    x_request_stats.renders++;
+    x_request_stats.heaviest = NULL;
+    x_request_stats.heaviest_requests = 0;
+    render_started = ev_time();
+}
+
+/*
+ * Finishes recording the requests of a render, adds it to the history and
+ * logs a summary.
+ *
+ */
+void x_request_stats_finish(void) {
+    const double duration = ev_time() - render_started;
+    uint32_t sent = 0;
+    for (int type = 0; type < XR_NUM_TYPES; type++) {
+        sent += x_request_stats.current[type];
+        x_request_stats.last[type] = x_request_stats.current[type];
+        x_request_stats.total[type] += x_request_stats.current[type];
+        x_request_stats.current[type] = 0;
+    }
+    x_request_stats.last_duration = duration;
+    render_started = 0;
+
+    const int idx = (x_request_stats.renders - 1) % X_REQUEST_HISTORY;
+    x_request_stats.history[idx].requests = sent;
+    x_request_stats.history[idx].duration = duration;
+
+    DLOG("Render took %.3f ms and sent %u X11 requests (%u configure, %u attributes, "
+         "%u copy, %u map, %u unmap, %u fill), most of them (%u) for con %p\n",
+         duration * 1000, sent,
+         x_request_stats.last[XR_CONFIGURE_WINDOW],
+         x_request_stats.last[XR_CHANGE_WINDOW_ATTRIBUTES],
+         x_request_stats.last[XR_COPY_AREA],
+         x_request_stats.last[XR_MAP_WINDOW],
+         x_request_stats.last[XR_UNMAP_WINDOW],
+         x_request_stats.last[XR_POLY_FILL_RECTANGLE],
+         x_request_stats.heaviest_requests, x_request_stats.heaviest);
+}
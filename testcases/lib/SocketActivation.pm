@@ -32,6 +32,7 @@ our @EXPORT = qw(activate_i3);
 # configfile: path to the configuration file to use
 # logpath: path to the logfile to which i3 will append
 # cv: an AnyEvent->condvar which will be triggered once i3 is ready
+# i3_args: additional command line arguments for i3 (optional)
 #
 sub activate_i3 {
     my %args = @_;
@@ -98,6 +99,7 @@ sub activate_i3 {
         # Force Xinerama because we use Xdmx for multi-monitor tests.
         my $i3cmd = abs_path("../i3") . q| -V -d all --disable-signalhandler| .
                                         q| --shmlog-size=0 --force-xinerama|;
+        $i3cmd .= " $args{i3_args}" if defined($args{i3_args});
 
         # For convenience:
         my $outdir = $args{outdir};
@@ -820,6 +820,10 @@ tests which test specific config file directives.
 
   exit_gracefully($pid);
 
+Additional command line arguments for i3 can be passed as C<i3_args>:
+
+  my $pid = launch_with_config($config, i3_args => '--shmlog-binary');
+
 =cut
 sub launch_with_config {
     my ($config, %args) = @_;
@@ -857,6 +861,7 @@ sub launch_with_config {
         restart => $ENV{RESTART},
         cv => $cv,
         dont_create_temp_dir => $args{dont_create_temp_dir},
+        i3_args => $args{i3_args},
     );
 
     # force update of the cached socket path in lib/i3test
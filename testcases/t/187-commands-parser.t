@@ -198,4 +198,23 @@ is(parser_calls("resize grow left 10 px or 20 ppt"),
    "cmd_resize(grow, left, 10, 20)",
    "resize command with 'or'-construction ok");
 
+################################################################################
+# 5: Verify that states with an empty literal (fullscreen without an action)
+# still accept any following input
+################################################################################
+
+is(parser_calls('fullscreen global'),
+   'cmd_fullscreen(toggle, global)',
+   'fullscreen global ok');
+
+is(parser_calls('fullscreen; nop foo'),
+   "cmd_fullscreen(toggle, output)\n" .
+   "cmd_nop(foo)",
+   'fullscreen; nop foo ok');
+
+is(parser_calls('fullscreen, nop foo'),
+   "cmd_fullscreen(toggle, output)\n" .
+   "cmd_nop(foo)",
+   'fullscreen, nop foo ok');
+
 done_testing;
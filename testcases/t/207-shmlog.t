@@ -15,7 +15,7 @@
 #   (unless you are already familiar with Perl)
 #
 use i3test i3_autostart => 0;
-use IPC::Run qw(run);
+use IPC::Run qw(run start);
 use File::Temp;
 
 ################################################################################
@@ -84,4 +84,92 @@ like($stderr, qr#^i3-dump-log: ERROR: i3 is running, but SHM logging is not enab
 
 exit_gracefully($pid);
 
+################################################################################
+# 5: verify that binary records are formatted by i3-dump-log, including the
+# source location of DLOG() calls
+################################################################################
+
+$pid = launch_with_config($config, i3_args => '--shmlog-binary');
+
+cmd 'shmlog on';
+
+$random_nop = mktemp('nop.XXXXXX');
+cmd "nop $random_nop";
+
+run [ '../i3-dump-log/i3-dump-log' ],
+    '>', \$stdout,
+    '2>', \$stderr;
+
+like($stdout, qr#^.* - \S*commands_parser\.c:parse_command:\d+ - COMMAND: \*nop \Q$random_nop\E\*$#m,
+     'random nop found in binary shm log, prefixed with file:function:line');
+like($stderr, qr#^$#, 'stderr empty');
+
+exit_gracefully($pid);
+
+################################################################################
+# 6: flood a small log while i3-dump-log -f -o follows it and verify that the
+# output contains no garbled lines, but reports what was lost
+################################################################################
+
+$pid = launch_with_config($config);
+
+cmd 'shmlog ' . (64 * 1024);
+
+my $outfile = File::Temp->new(TEMPLATE => 'i3-dump-log-XXXXXX', TMPDIR => 1);
+my $dump = start [ '../i3-dump-log/i3-dump-log', '-f', '-o', "$outfile" ];
+
+sub dumped_log {
+    open(my $fh, '<', "$outfile") or return '';
+    local $/;
+    return scalar <$fh>;
+}
+
+sub wait_for_dumped {
+    my ($pattern) = @_;
+    for (1 .. 500) {
+        return 1 if dumped_log() =~ $pattern;
+        select(undef, undef, undef, 0.01);
+    }
+    return 0;
+}
+
+my $first_nop = mktemp('nop.XXXXXX');
+cmd "nop $first_nop";
+ok(wait_for_dumped(qr#NOP: \Q$first_nop\E$#m), 'i3-dump-log -f wrote the first nop');
+
+# Stop i3-dump-log so that i3 is guaranteed to overwrite lines it did not
+# read yet.
+$dump->signal('STOP');
+cmd "nop flood-$_" for 1 .. 2000;
+$dump->signal('CONT');
+
+my $last_nop = mktemp('nop.XXXXXX');
+cmd "nop $last_nop";
+ok(wait_for_dumped(qr#NOP: \Q$last_nop\E$#m), 'i3-dump-log -f wrote the last nop');
+
+$dump->kill_kill;
+
+my $dumped = dumped_log();
+like($dumped, qr#^i3-dump-log: \d+ bytes lost, i3 overwrote them before they could be read$#m,
+     'lost lines reported');
+
+# Every other line starts with a timestamp in the format of the first nop’s
+# line and contains only one of them. Lines of the flood contain one complete
+# nop argument.
+my ($timestamp) = ($dumped =~ /^(.*?) - .*NOP: \Q$first_nop\E$/m);
+(my $timestamp_re = quotemeta($timestamp)) =~ s/\d/\\d/g;
+my @garbled;
+for my $line (split(/\n/, $dumped)) {
+    next if $line =~ /^i3-dump-log: \d+ bytes lost/;
+    my $floods = () = ($line =~ /flood-/g);
+    push @garbled, $line
+        if $line !~ /^$timestamp_re - / ||
+           $line =~ /.$timestamp_re - / ||
+           $floods > 1 ||
+           ($floods == 1 && $line !~ /flood-\d+(\*|$)/);
+}
+is(scalar @garbled, 0, 'no garbled lines') or diag(join("\n", @garbled));
+
+exit_gracefully($pid);
+
 done_testing;
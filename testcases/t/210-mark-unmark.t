@@ -158,6 +158,32 @@ is($result->[0]->{error}, 'A mark must not be put onto more than one window', 'c
 ok(!get_mark_for_window_on_workspace($tmp, $first), 'first container is not marked');
 ok(!get_mark_for_window_on_workspace($tmp, $second), 'second containr is not marked');
 
+##############################################################
+# 10: use con_mark criteria matching several marks, check that
+#     exactly the marked containers are affected and that
+#     unmarked containers no longer match
+##############################################################
+
+cmd 'unmark';
+
+$tmp = fresh_workspace;
+$first = open_window;
+cmd 'mark crit_a';
+$second = open_window;
+cmd 'mark crit_b';
+my $third = open_window;
+cmd 'mark other';
+
+cmd '[con_mark="^crit_"] kill';
+sync_with_i3;
+is(@{get_ws_content($tmp)}, 1, 'both containers marked crit_* were killed');
+is_deeply(get_marks(), [ 'other' ], 'marks gone with the killed containers');
+
+cmd 'unmark other';
+cmd '[con_mark="."] kill';
+sync_with_i3;
+is(@{get_ws_content($tmp)}, 1, 'unmarked container does not match con_mark');
+
 ##############################################################
 
 done_testing;
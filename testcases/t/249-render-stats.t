@@ -0,0 +1,56 @@
+#!perl
+# vim:ts=4:sw=4:expandtab
+#
+# Please read the following documents before working on tests:
+# • http://build.i3wm.org/docs/testsuite.html
+#   (or docs/testsuite)
+#
+# • http://build.i3wm.org/docs/lib-i3test.html
+#   (alternatively: perldoc ./testcases/lib/i3test.pm)
+#
+# • http://build.i3wm.org/docs/ipc.html
+#   (or docs/ipc)
+#
+# • http://onyxneon.com/books/modern_perl/modern_perl_a4.pdf
+#   (unless you are already familiar with Perl)
+#
+# Verifies that the gaps are only recomputed for workspaces which changed when
+# rendering and that the render statistics are available via IPC.
+use i3test;
+
+my $i3 = i3(get_socket_path());
+$i3->connect->recv;
+
+sub render_stats {
+    return $i3->message(8, "")->recv;
+}
+
+fresh_workspace;
+
+open_window for 1..3;
+
+cmd 'focus left';
+my $stats = render_stats;
+my $frames = $stats->{frames};
+cmp_ok($stats->{rendered}, '>', 0, 'containers were rendered');
+cmp_ok($stats->{gaps_recomputed}, '<', $stats->{rendered}, 'not all gaps were recomputed');
+my $clean = $stats->{gaps_recomputed};
+
+# Focus changes do not influence the gaps, so the workspace is not dirty.
+cmd 'focus left';
+$stats = render_stats;
+cmp_ok($stats->{frames}, '>', $frames, 'frame counter increased');
+is($stats->{gaps_recomputed}, $clean, 'focus change does not recompute the gaps');
+
+# Changing the layout creates a new split container and moves all windows,
+# so the gaps of the (stacked) split container and all three windows are
+# recomputed. The workspace itself has no gaps of its own.
+cmd 'layout stacking';
+$stats = render_stats;
+cmp_ok($stats->{gaps_recomputed}, '>=', $clean + 4, 'layout change recomputes the gaps');
+
+cmd 'focus up';
+$stats = render_stats;
+is($stats->{gaps_recomputed}, $clean, 'workspace is clean again after rendering');
+
+done_testing;
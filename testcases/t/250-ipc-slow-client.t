@@ -0,0 +1,92 @@
+#!perl
+# vim:ts=4:sw=4:expandtab
+#
+# Please read the following documents before working on tests:
+# • http://build.i3wm.org/docs/testsuite.html
+#   (or docs/testsuite)
+#
+# • http://build.i3wm.org/docs/lib-i3test.html
+#   (alternatively: perldoc ./testcases/lib/i3test.pm)
+#
+# • http://build.i3wm.org/docs/ipc.html
+#   (or docs/ipc)
+#
+# • http://onyxneon.com/books/modern_perl/modern_perl_a4.pdf
+#   (unless you are already familiar with Perl)
+#
+# Verifies that an IPC client which subscribes to events but never reads them
+# does not block i3 and gets disconnected once it exceeds ipc_buffer_limit.
+use i3test i3_autostart => 0;
+use IO::Select;
+use IO::Socket::UNIX;
+use JSON::XS;
+
+my $config = <<EOT;
+# i3 config file (v4)
+font -misc-fixed-medium-r-normal--13-120-75-75-C-70-iso10646-1
+
+ipc_buffer_limit 64 kb
+EOT
+my $pid = launch_with_config($config);
+
+my $sock = IO::Socket::UNIX->new(Peer => get_socket_path());
+ok(defined($sock), 'connected to i3');
+
+my $payload = '["workspace"]';
+$sock->syswrite('i3-ipc' . pack('LL', length($payload), 2) . $payload);
+
+my $ws1 = fresh_workspace;
+open_window;
+my $ws2 = fresh_workspace;
+open_window;
+
+# Every workspace switch sends a workspace event containing both workspaces,
+# which the client never reads. Without output buffering, i3 would block as
+# soon as the socket buffer is full.
+for (1 .. 500) {
+    cmd "workspace $ws1";
+    cmd "workspace $ws2";
+}
+
+does_i3_live;
+
+# The client should have been disconnected: after reading what was written to
+# the socket before, we get EOF.
+my $select = IO::Select->new($sock);
+my $eof = 0;
+while ($select->can_read(5)) {
+    my $buf;
+    if (!sysread($sock, $buf, 65536)) {
+        $eof = 1;
+        last;
+    }
+}
+ok($eof, 'slow client was disconnected');
+
+exit_gracefully($pid);
+
+################################################################################
+# A single reply which is bigger than ipc_buffer_limit does not get a client
+# disconnected as long as it reads the reply: only output which could not be
+# written right away counts against the limit.
+################################################################################
+
+$config = <<EOT;
+# i3 config file (v4)
+font -misc-fixed-medium-r-normal--13-120-75-75-C-70-iso10646-1
+
+ipc_buffer_limit 1 kb
+EOT
+$pid = launch_with_config($config);
+
+fresh_workspace;
+open_window for 1 .. 3;
+
+my $i3 = i3(get_socket_path());
+my $tree = $i3->get_tree->recv;
+ok(length(encode_json($tree)) > 1024, 'tree is bigger than the limit');
+ok(defined($i3->get_tree->recv), 'client is still connected');
+
+exit_gracefully($pid);
+
+done_testing;
@@ -0,0 +1,104 @@
+#!perl
+# vim:ts=4:sw=4:expandtab
+#
+# Please read the following documents before working on tests:
+# • http://build.i3wm.org/docs/testsuite.html
+#   (or docs/testsuite)
+#
+# • http://build.i3wm.org/docs/lib-i3test.html
+#   (alternatively: perldoc ./testcases/lib/i3test.pm)
+#
+# • http://build.i3wm.org/docs/ipc.html
+#   (or docs/ipc)
+#
+# • http://onyxneon.com/books/modern_perl/modern_perl_a4.pdf
+#   (unless you are already familiar with Perl)
+#
+# Verifies that the "tree" event reports added, changed and removed
+# containers and that GET_TREE contains the generation counter.
+# AnyEvent::I3 does not know about the "tree" event, so we talk to i3
+# directly.
+use i3test;
+use IO::Select;
+use IO::Socket::UNIX;
+use JSON::XS;
+
+my $sock = IO::Socket::UNIX->new(Peer => get_socket_path());
+ok(defined($sock), 'connected to i3');
+
+sub read_message {
+    my $select = IO::Select->new($sock);
+    return undef unless $select->can_read(5);
+
+    my $header;
+    sysread($sock, $header, 14) == 14 or return undef;
+    my ($len, $type) = unpack('LL', substr($header, 6));
+    my $payload = '';
+    while (length($payload) < $len) {
+        sysread($sock, $payload, $len - length($payload), length($payload)) or return undef;
+    }
+    return decode_json($payload);
+}
+
+# Returns all changes of the tree events until one matches the callback.
+sub wait_for_change {
+    my ($cb) = @_;
+    while (defined(my $event = read_message())) {
+        for my $change (@{$event->{changes}}) {
+            return ($event, $change) if $cb->($change);
+        }
+    }
+    return ();
+}
+
+my $payload = '["tree"]';
+$sock->syswrite('i3-ipc' . pack('LL', length($payload), 2) . $payload);
+ok(read_message()->{success}, 'subscribed to the tree event');
+
+my $i3 = i3(get_socket_path());
+my $tree = $i3->get_tree->recv;
+ok(defined($tree->{generation}), 'GET_TREE contains the generation');
+
+fresh_workspace;
+
+################################################################################
+# Opening a window is reported as an "added" change with all fields.
+################################################################################
+
+my $window = open_window;
+
+my ($event, $added) = wait_for_change(sub {
+    $_[0]->{change} eq 'added' && defined($_[0]->{fields}->{window}) &&
+    $_[0]->{fields}->{window} == $window->id
+});
+ok(defined($added), 'window was added');
+ok(defined($added->{parent}), 'added change contains the parent');
+is($added->{fields}->{type}, 'con', 'added change contains the type');
+ok($event->{generation} > $tree->{generation}, 'generation increased');
+
+my $id = $added->{id};
+
+################################################################################
+# Marking the window is reported as a "property" change with only that field.
+################################################################################
+
+cmd 'mark foo';
+
+my (undef, $changed) = wait_for_change(sub {
+    $_[0]->{change} eq 'property' && $_[0]->{id} == $id
+});
+ok(defined($changed), 'mark was reported');
+is_deeply($changed->{fields}, { mark => 'foo' }, 'only the mark changed');
+
+################################################################################
+# Killing the window is reported as a "removed" change.
+################################################################################
+
+cmd 'kill';
+
+my (undef, $removed) = wait_for_change(sub {
+    $_[0]->{change} eq 'removed' && $_[0]->{id} == $id
+});
+ok(defined($removed), 'window was removed');
+
+done_testing;
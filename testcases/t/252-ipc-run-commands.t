@@ -0,0 +1,78 @@
+#!perl
+# vim:ts=4:sw=4:expandtab
+#
+# Please read the following documents before working on tests:
+# • http://build.i3wm.org/docs/testsuite.html
+#   (or docs/testsuite)
+#
+# • http://build.i3wm.org/docs/lib-i3test.html
+#   (alternatively: perldoc ./testcases/lib/i3test.pm)
+#
+# • http://build.i3wm.org/docs/ipc.html
+#   (or docs/ipc)
+#
+# • http://onyxneon.com/books/modern_perl/modern_perl_a4.pdf
+#   (unless you are already familiar with Perl)
+#
+# Verifies that RUN_COMMANDS executes all given commands, replies with the
+# result of each of them and renders the tree only once.
+use i3test;
+use JSON::XS;
+
+my $i3 = i3(get_socket_path());
+$i3->connect->recv;
+
+sub run_commands {
+    return $i3->message(9, encode_json([ @_ ]))->recv;
+}
+
+sub frames {
+    return $i3->message(8, "")->recv->{frames};
+}
+
+my $tmp = fresh_workspace;
+
+open_window for 1..3;
+
+my $frames = frames;
+my $reply = run_commands('border pixel 1', 'layout tabbed', 'focus left; border none', 'mark foo');
+is(frames, $frames + 1, 'tree was rendered once');
+
+is(scalar @$reply, 4, 'one result per command string');
+is(scalar @{$reply->[2]}, 2, 'two results for the chained commands');
+ok((!grep { !$_->{success} } map { @$_ } @$reply), 'all commands succeeded');
+
+my @content = @{get_ws_content($tmp)};
+is($content[0]->{layout}, 'tabbed', 'layout was changed');
+is($content[0]->{nodes}->[1]->{border}, 'none', 'border of the focused window was changed');
+is($content[0]->{nodes}->[1]->{mark}, 'foo', 'focused window was marked');
+
+################################################################################
+# Errors are reported for the command string which failed only.
+################################################################################
+
+$reply = run_commands('nosuchcommand', 'layout splith');
+ok(!$reply->[0]->[0]->{success}, 'invalid command failed');
+ok($reply->[0]->[0]->{parse_error}, 'invalid command is a parse error');
+ok($reply->[1]->[0]->{success}, 'following command succeeded anyway');
+
+$reply = $i3->message(9, 'no json')->recv;
+ok(!$reply->{success}, 'invalid payload is rejected');
+
+################################################################################
+# Only a flat array of strings is accepted. Otherwise, none of the commands
+# are run, not even those before the invalid element.
+################################################################################
+
+for my $payload ('["mark bar", ["mark baz"]]', '["mark bar", {"mark": "baz"}]',
+                 '{"commands": ["mark bar"]}', '"mark bar"', '["mark bar", 1]',
+                 '["mark bar", null]', '[["mark bar"]]') {
+    $reply = $i3->message(9, $payload)->recv;
+    is(ref($reply), 'HASH', "payload $payload is rejected");
+    ok(!$reply->{success}, "payload $payload is not successful");
+}
+
+@content = @{get_ws_content($tmp)};
+is($content[0]->{nodes}->[1]->{mark}, 'foo', 'no command of a rejected payload was run');
+
+done_testing;
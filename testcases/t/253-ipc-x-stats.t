@@ -0,0 +1,62 @@
+#!perl
+# vim:ts=4:sw=4:expandtab
+#
+# Please read the following documents before working on tests:
+# • http://build.i3wm.org/docs/testsuite.html
+#   (or docs/testsuite)
+#
+# • http://build.i3wm.org/docs/lib-i3test.html
+#   (alternatively: perldoc ./testcases/lib/i3test.pm)
+#
+# • http://build.i3wm.org/docs/ipc.html
+#   (or docs/ipc)
+#
+# • http://onyxneon.com/books/modern_perl/modern_perl_a4.pdf
+#   (unless you are already familiar with Perl)
+#
+# Verifies that the X11 requests sent while rendering are counted and available
+# via the GET_X_STATS IPC request, and that a focus change does not toggle the
+# event masks of all frames.
+use i3test;
+use List::Util qw(sum);
+
+my $i3 = i3(get_socket_path());
+$i3->connect->recv;
+
+sub x_stats {
+    return $i3->message(10, "")->recv;
+}
+
+fresh_workspace;
+
+my $stats = x_stats;
+my $renders = $stats->{renders};
+my $mapped = $stats->{total}->{map_window};
+
+open_window for 1..3;
+
+$stats = x_stats;
+cmp_ok($stats->{renders}, '>', $renders, 'render counter increased');
+cmp_ok($stats->{total}->{map_window}, '>=', $mapped + 6, 'frames and windows were mapped');
+is(sum(map { $_->{renders} } @{$stats->{histogram}}), $stats->{samples}, 'histogram covers all samples');
+is($stats->{histogram}->[-1]->{max}, undef, 'last bucket is open-ended');
+
+# A focus change does not map, move or restack anything, so only the event
+# mask of the newly focused window is changed (twice, see x_push_changes()).
+cmd 'focus left';
+$stats = x_stats;
+cmp_ok($stats->{last}->{requests}->{change_window_attributes}, '<', 6,
+       'event masks of the frames were not toggled');
+cmp_ok($stats->{last}->{requests}->{copy_area}, '>', 0, 'decorations were redrawn');
+ok(defined($stats->{last}->{heaviest_container}), 'heaviest container is known');
+cmp_ok($stats->{last}->{heaviest_requests}, '>', 0, 'heaviest container sent requests');
+
+# The width of a mark is measured whenever the decoration is redrawn, which
+# happens when the marked window loses focus.
+cmd 'mark x-stats';
+my $hits = x_stats->{text_width_cache}->{hits};
+cmd 'focus right';
+$stats = x_stats;
+cmp_ok($stats->{text_width_cache}->{hits}, '>', $hits, 'text widths were cached');
+
+done_testing;
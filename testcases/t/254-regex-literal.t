@@ -0,0 +1,91 @@
+#!perl
+# vim:ts=4:sw=4:expandtab
+#
+# Please read the following documents before working on tests:
+# • http://build.i3wm.org/docs/testsuite.html
+#   (or docs/testsuite)
+#
+# • http://build.i3wm.org/docs/lib-i3test.html
+#   (alternatively: perldoc ./testcases/lib/i3test.pm)
+#
+# • http://build.i3wm.org/docs/ipc.html
+#   (or docs/ipc)
+#
+# • http://onyxneon.com/books/modern_perl/modern_perl_a4.pdf
+#   (unless you are already familiar with Perl)
+#
+# Verifies that patterns without metacharacters (which are matched without
+# PCRE) match the same windows as PCRE would, in criteria and in for_window,
+# also when the same criteria are used again after a reload.
+use i3test i3_autostart => 0;
+
+my $config = <<'EOT';
+# i3 config file (v4)
+font -misc-fixed-medium-r-normal--13-120-75-75-C-70-iso10646-1
+
+for_window [title="^literal floating$"] floating enable
+EOT
+my $pid = launch_with_config($config);
+
+################################################################################
+# for_window with an anchored literal only matches the exact title.
+################################################################################
+
+my $tmp = fresh_workspace;
+
+open_window(name => 'literal floating');
+open_window(name => 'literal floating window');
+
+my $ws = get_ws($tmp);
+is(scalar @{$ws->{floating_nodes}}, 1, 'one window is floating');
+is($ws->{floating_nodes}->[0]->{nodes}->[0]->{name}, 'literal floating',
+   'the window with the exact title is floating');
+is(scalar @{$ws->{nodes}}, 1, 'the other window is tiling');
+
+################################################################################
+# Criteria with literal patterns, anchored and not, and with metacharacters.
+################################################################################
+
+$tmp = fresh_workspace;
+
+open_window(name => $_, wm_class => 'regex-literal')
+    for ('foo', 'foo bar', 'bar foo', 'xfoox');
+
+# Returns the sorted titles of the windows which the given title pattern
+# matches, by setting their border.
+sub matching {
+    my ($pattern) = @_;
+    cmd '[class="^regex-literal$"] border normal';
+    cmd qq|[title="$pattern"] border pixel 1|;
+    return [ sort map { $_->{name} } grep { $_->{border} eq 'pixel' } @{get_ws_content($tmp)} ];
+}
+
+my %expected = (
+    '^foo$' => [ 'foo' ],
+    'foo$' => [ 'bar foo', 'foo' ],
+    '^foo' => [ 'foo', 'foo bar' ],
+    'foo' => [ 'bar foo', 'foo', 'foo bar', 'xfoox' ],
+    'oo b' => [ 'foo bar' ],
+    '^fo+ b' => [ 'foo bar' ],
+    'x.o' => [ 'xfoox' ],
+    '^(foo|bar)$' => [ 'foo' ],
+    '^nothing$' => [ ],
+);
+
+for my $pattern (sort keys %expected) {
+    is_deeply(matching($pattern), $expected{$pattern}, "$pattern matches the right windows");
+}
+
+################################################################################
+# The same criteria still match the same windows after a reload.
+################################################################################
+
+cmd 'reload';
+
+for my $pattern (sort keys %expected) {
+    is_deeply(matching($pattern), $expected{$pattern}, "$pattern matches the right windows after a reload");
+}
+
+exit_gracefully($pid);
+
+done_testing;